@@ -0,0 +1,249 @@
+#include "Image.hpp"
+
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string_view>
+
+#include <fmt/format.h>
+#include <zlib.h>
+
+#include "../SplineNetwork/FileHandler/MappedFile.hpp"
+
+namespace {
+	constexpr std::array<uint8_t, 8> pngSignature = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+
+	uint32_t readBigEndian(const char *data) {
+		const auto *bytes = reinterpret_cast<const uint8_t *>(data);
+		return uint32_t(bytes[0]) << 24 | uint32_t(bytes[1]) << 16 | uint32_t(bytes[2]) << 8 | uint32_t(bytes[3]);
+	}
+	void appendBigEndian(std::vector<uint8_t> &out, uint32_t value) {
+		out.push_back(static_cast<uint8_t>(value >> 24));
+		out.push_back(static_cast<uint8_t>(value >> 16));
+		out.push_back(static_cast<uint8_t>(value >> 8));
+		out.push_back(static_cast<uint8_t>(value));
+	}
+
+	/// Walks the chunks of a PNG file
+	class PngChunkReader {
+		std::span<const char> _data;
+		size_t _pos = pngSignature.size();
+		const std::filesystem::path &_path;
+
+	public:
+		PngChunkReader(std::span<const char> data, const std::filesystem::path &path)
+		    : _data(data)
+		    , _path(path) {
+			if (_data.size() < pngSignature.size() || std::memcmp(_data.data(), pngSignature.data(), 8) != 0)
+				throw std::runtime_error(fmt::format("{}: Not a PNG file", _path.string()));
+		}
+
+		/// Returns the type and contents of the next chunk, or an empty type at the end of the file
+		std::pair<std::string_view, std::span<const char>> next() {
+			if (_pos + 8 > _data.size())
+				return {};
+
+			const auto length = readBigEndian(&_data[_pos]);
+			const std::string_view type(&_data[_pos + 4], 4);
+			// Length, type, data and CRC
+			if (_pos + 12 + length > _data.size())
+				throw std::runtime_error(fmt::format("{}: Truncated {} chunk", _path.string(), type));
+
+			const std::span<const char> contents(&_data[_pos + 8], length);
+			_pos += 12 + length;
+			return {type, contents};
+		}
+	};
+
+	uint8_t paeth(uint8_t a, uint8_t b, uint8_t c) {
+		const int p = a + b - c;
+		const int pa = std::abs(p - a);
+		const int pb = std::abs(p - b);
+		const int pc = std::abs(p - c);
+		if (pa <= pb && pa <= pc)
+			return a;
+		if (pb <= pc)
+			return b;
+		return c;
+	}
+
+	void writeChunk(std::ofstream &file, std::string_view type, std::span<const uint8_t> contents) {
+		std::vector<uint8_t> header;
+		appendBigEndian(header, static_cast<uint32_t>(contents.size()));
+		header.insert(header.end(), type.begin(), type.end());
+
+		auto crc = crc32(0, reinterpret_cast<const Bytef *>(type.data()), 4);
+		crc = crc32(crc, contents.data(), static_cast<uInt>(contents.size()));
+		std::vector<uint8_t> footer;
+		appendBigEndian(footer, static_cast<uint32_t>(crc));
+
+		file.write(reinterpret_cast<const char *>(header.data()), static_cast<std::streamsize>(header.size()));
+		file.write(reinterpret_cast<const char *>(contents.data()), static_cast<std::streamsize>(contents.size()));
+		file.write(reinterpret_cast<const char *>(footer.data()), static_cast<std::streamsize>(footer.size()));
+	}
+} // namespace
+
+Image::Image(uint32_t width, uint32_t height, Colour fill)
+    : _width(width)
+    , _height(height)
+    , _pixels(static_cast<size_t>(width) * height * 3) {
+	for (size_t i = 0; i < _pixels.size(); i += 3) {
+		_pixels[i] = fill.r;
+		_pixels[i + 1] = fill.g;
+		_pixels[i + 2] = fill.b;
+	}
+}
+
+std::pair<uint32_t, uint32_t> Image::readPngSize(const std::filesystem::path &path) {
+	const MappedFile file(path);
+	PngChunkReader chunks(file.data(), path);
+
+	const auto [type, contents] = chunks.next();
+	if (type != "IHDR" || contents.size() < 8)
+		throw std::runtime_error(fmt::format("{}: PNG does not start with a header", path.string()));
+
+	return {readBigEndian(&contents[0]), readBigEndian(&contents[4])};
+}
+
+Image Image::readPng(const std::filesystem::path &path) {
+	const MappedFile file(path);
+	PngChunkReader chunks(file.data(), path);
+
+	uint32_t width = 0;
+	uint32_t height = 0;
+	uint8_t colourType = 0;
+	std::vector<uint8_t> compressed;
+	std::vector<Colour> palette;
+	while (true) {
+		const auto [type, contents] = chunks.next();
+		if (type.empty() || type == "IEND")
+			break;
+
+		if (type == "IHDR") {
+			if (contents.size() < 13)
+				throw std::runtime_error(fmt::format("{}: Truncated PNG header", path.string()));
+			width = readBigEndian(&contents[0]);
+			height = readBigEndian(&contents[4]);
+			const auto bitDepth = static_cast<uint8_t>(contents[8]);
+			colourType = static_cast<uint8_t>(contents[9]);
+			const auto interlace = static_cast<uint8_t>(contents[12]);
+			if (bitDepth != 8 || interlace != 0) {
+				throw std::runtime_error(fmt::format(
+				    "{}: Only non-interlaced 8-bit PNGs are supported (got {}-bit, interlace {})", path.string(),
+				    bitDepth, interlace));
+			}
+		} else if (type == "PLTE") {
+			for (size_t i = 0; i + 2 < contents.size(); i += 3) {
+				palette.push_back({static_cast<uint8_t>(contents[i]), static_cast<uint8_t>(contents[i + 1]),
+				                   static_cast<uint8_t>(contents[i + 2])});
+			}
+		} else if (type == "IDAT") {
+			compressed.insert(compressed.end(), contents.begin(), contents.end());
+		}
+	}
+
+	// Bytes per pixel for grey, -, RGB, palette, grey+alpha, -, RGBA
+	constexpr std::array<uint8_t, 7> channelCounts = {1, 0, 3, 1, 2, 0, 4};
+	if (colourType >= channelCounts.size() || channelCounts[colourType] == 0)
+		throw std::runtime_error(fmt::format("{}: Unknown PNG colour type {}", path.string(), colourType));
+	const size_t channels = channelCounts[colourType];
+	const size_t stride = width * channels;
+
+	// Every row is prefixed by its filter type
+	std::vector<uint8_t> filtered((stride + 1) * height);
+	auto filteredSize = static_cast<uLongf>(filtered.size());
+	if (uncompress(filtered.data(), &filteredSize, compressed.data(), static_cast<uLong>(compressed.size())) != Z_OK ||
+	    filteredSize != filtered.size()) {
+		throw std::runtime_error(fmt::format("{}: Corrupt PNG image data", path.string()));
+	}
+
+	Image image(width, height);
+	std::vector<uint8_t> previous(stride, 0);
+	std::vector<uint8_t> current(stride);
+	for (uint32_t y = 0; y < height; ++y) {
+		const uint8_t *in = &filtered[y * (stride + 1)];
+		const uint8_t filter = in[0];
+		++in;
+
+		for (size_t i = 0; i < stride; ++i) {
+			const uint8_t left = i >= channels ? current[i - channels] : 0;
+			const uint8_t up = previous[i];
+			const uint8_t upLeft = i >= channels ? previous[i - channels] : 0;
+			switch (filter) {
+			case 0: current[i] = in[i]; break;
+			case 1: current[i] = in[i] + left; break;
+			case 2: current[i] = in[i] + up; break;
+			case 3: current[i] = in[i] + (left + up) / 2; break;
+			case 4: current[i] = in[i] + paeth(left, up, upLeft); break;
+			default: throw std::runtime_error(fmt::format("{}: Unknown PNG filter {}", path.string(), filter));
+			}
+		}
+
+		for (uint32_t x = 0; x < width; ++x) {
+			const uint8_t *p = &current[x * channels];
+			if (colourType == 3) {
+				image.pixel(x, y, p[0] < palette.size() ? palette[p[0]] : Colour{});
+			} else if (channels <= 2) {
+				image.pixel(x, y, {p[0], p[0], p[0]});
+			} else {
+				image.pixel(x, y, {p[0], p[1], p[2]});
+			}
+		}
+
+		std::swap(previous, current);
+	}
+
+	return image;
+}
+
+void Image::writeToFile(const std::filesystem::path &path) const {
+	if (path.extension() == ".ppm")
+		writePpm(path);
+	else
+		writePng(path);
+}
+void Image::writePng(const std::filesystem::path &path) const {
+	std::ofstream file;
+	file.exceptions(std::ios::badbit | std::ios::failbit);
+	file.open(path, std::ios::out | std::ios::binary | std::ios::trunc);
+
+	file.write(reinterpret_cast<const char *>(pngSignature.data()), pngSignature.size());
+
+	std::vector<uint8_t> header;
+	appendBigEndian(header, _width);
+	appendBigEndian(header, _height);
+	// 8-bit RGB, default compression and filtering, no interlacing
+	header.insert(header.end(), {8, 2, 0, 0, 0});
+	writeChunk(file, "IHDR", header);
+
+	// The renders are mostly flat colour, so the Sub filter compresses them well
+	const size_t stride = static_cast<size_t>(_width) * 3;
+	std::vector<uint8_t> filtered;
+	filtered.reserve((stride + 1) * _height);
+	for (uint32_t y = 0; y < _height; ++y) {
+		const auto in = row(y);
+		filtered.push_back(1);
+		for (size_t i = 0; i < stride; ++i)
+			filtered.push_back(static_cast<uint8_t>(in[i] - (i >= 3 ? in[i - 3] : 0)));
+	}
+
+	auto compressedSize = compressBound(static_cast<uLong>(filtered.size()));
+	std::vector<uint8_t> compressed(compressedSize);
+	if (compress2(compressed.data(), &compressedSize, filtered.data(), static_cast<uLong>(filtered.size()),
+	              Z_BEST_SPEED) != Z_OK) {
+		throw std::runtime_error(fmt::format("{}: Failed to compress image", path.string()));
+	}
+	compressed.resize(compressedSize);
+	writeChunk(file, "IDAT", compressed);
+
+	writeChunk(file, "IEND", {});
+}
+void Image::writePpm(const std::filesystem::path &path) const {
+	std::ofstream file;
+	file.exceptions(std::ios::badbit | std::ios::failbit);
+	file.open(path, std::ios::out | std::ios::binary | std::ios::trunc);
+
+	file << fmt::format("P6\n{} {}\n255\n", _width, _height);
+	file.write(reinterpret_cast<const char *>(_pixels.data()), static_cast<std::streamsize>(_pixels.size()));
+}
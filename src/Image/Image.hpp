@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <utility>
+#include <vector>
+
+struct Colour {
+	uint8_t r = 0;
+	uint8_t g = 0;
+	uint8_t b = 0;
+
+	bool operator==(const Colour &other) const = default;
+};
+
+/// An 8-bit RGB image, with (0,0) at the top left like the image files
+/// Only supports the subset of PNG the game's map images use: 8-bit, non-interlaced
+class Image {
+	uint32_t _width = 0;
+	uint32_t _height = 0;
+	std::vector<uint8_t> _pixels;
+
+	void writePng(const std::filesystem::path &path) const;
+	void writePpm(const std::filesystem::path &path) const;
+
+public:
+	Image() = default;
+	Image(uint32_t width, uint32_t height, Colour fill = {});
+
+	/// Decode an entire PNG file
+	static Image readPng(const std::filesystem::path &path);
+	/// Read only the dimensions from a PNG's header, without decoding the image
+	static std::pair<uint32_t, uint32_t> readPngSize(const std::filesystem::path &path);
+
+	/// Write as PNG or binary PPM depending on the extension of `path`
+	void writeToFile(const std::filesystem::path &path) const;
+
+	[[nodiscard]] auto width() const { return _width; }
+	[[nodiscard]] auto height() const { return _height; }
+
+	[[nodiscard]] Colour pixel(uint32_t x, uint32_t y) const {
+		const auto *p = &_pixels[(static_cast<size_t>(y) * _width + x) * 3];
+		return {p[0], p[1], p[2]};
+	}
+	void pixel(uint32_t x, uint32_t y, Colour set) {
+		auto *p = &_pixels[(static_cast<size_t>(y) * _width + x) * 3];
+		p[0] = set.r;
+		p[1] = set.g;
+		p[2] = set.b;
+	}
+	/// One row of tightly packed RGB triplets
+	[[nodiscard]] std::span<const uint8_t> row(uint32_t y) const {
+		return {&_pixels[static_cast<size_t>(y) * _width * 3], static_cast<size_t>(_width) * 3};
+	}
+};
@@ -0,0 +1,147 @@
+#include "ProvinceMap.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <fstream>
+#include <ranges>
+#include <sstream>
+#include <string_view>
+#include <vector>
+
+#include <fmt/format.h>
+
+namespace {
+	std::string readText(const std::filesystem::path &path) {
+		std::ifstream file;
+		file.exceptions(std::ios::badbit | std::ios::failbit);
+		file.open(path, std::ios::in | std::ios::binary);
+		std::stringstream contents;
+		contents << file.rdbuf();
+		return contents.str();
+	}
+
+	/// Split a Clausewitz script into `{`, `}`, `=`, and words, with quotes and comments removed
+	/// Nowhere near a full parser, but enough to find the province lists
+	std::vector<std::string_view> tokenize(std::string_view text) {
+		std::vector<std::string_view> tokens;
+		size_t i = 0;
+		while (i < text.size()) {
+			const char c = text[i];
+			if (std::isspace(static_cast<unsigned char>(c))) {
+				++i;
+			} else if (c == '#') {
+				i = std::min(text.find('\n', i), text.size());
+			} else if (c == '{' || c == '}' || c == '=') {
+				tokens.push_back(text.substr(i, 1));
+				++i;
+			} else if (c == '"') {
+				const auto end = std::min(text.find('"', i + 1), text.size());
+				tokens.push_back(text.substr(i + 1, end - i - 1));
+				i = end + 1;
+			} else {
+				const auto start = i;
+				while (i < text.size() && !std::isspace(static_cast<unsigned char>(text[i])) &&
+				       std::string_view("{}=#\"").find(text[i]) == std::string_view::npos)
+					++i;
+				tokens.push_back(text.substr(start, i - start));
+			}
+		}
+		return tokens;
+	}
+
+	/// Parse "x1A2B3C" into 0x1A2B3C
+	std::optional<uint32_t> parseColour(std::string_view token) {
+		if (token.size() != 7 || (token[0] != 'x' && token[0] != 'X'))
+			return std::nullopt;
+		const auto isHex = [](char c) { return std::isxdigit(static_cast<unsigned char>(c)) != 0; };
+		if (!std::all_of(token.begin() + 1, token.end(), isHex))
+			return std::nullopt;
+		return static_cast<uint32_t>(std::stoul(std::string(token.substr(1)), nullptr, 16));
+	}
+
+	/// Call `callback` with every province in the `key = { ... }` blocks at the given depth
+	template <typename F>
+	void forEachProvinceIn(const std::vector<std::string_view> &tokens, std::string_view key, int depth, F callback) {
+		int currentDepth = 0;
+		int listDepth = -1;
+		std::string_view blockName;
+		for (size_t i = 0; i < tokens.size(); ++i) {
+			const auto token = tokens[i];
+			if (token == "{") {
+				if (currentDepth == depth && i >= 2 && tokens[i - 1] == "=" && tokens[i - 2] == key)
+					listDepth = currentDepth + 1;
+				if (currentDepth == 0 && i >= 2 && tokens[i - 1] == "=")
+					blockName = tokens[i - 2];
+				++currentDepth;
+			} else if (token == "}") {
+				--currentDepth;
+				if (currentDepth < listDepth)
+					listDepth = -1;
+			} else if (currentDepth == listDepth) {
+				if (const auto colour = parseColour(token))
+					callback(blockName, *colour);
+			}
+		}
+	}
+} // namespace
+
+ProvinceMap::ProvinceMap(const std::filesystem::path &provincesPath)
+    : _image(Image::readPng(provincesPath)) {}
+
+void ProvinceMap::loadDefaultMap(const std::filesystem::path &defaultMapPath) {
+	const auto text = readText(defaultMapPath);
+	const auto tokens = tokenize(text);
+
+	auto addWater = [&](std::string_view, uint32_t colour) { _waterProvinces.emplace(colour); };
+	forEachProvinceIn(tokens, "sea_starts", 0, addWater);
+	forEachProvinceIn(tokens, "lakes", 0, addWater);
+}
+void ProvinceMap::loadStateRegions(const std::filesystem::path &stateRegionsDirectory) {
+	for (const auto &entry : std::filesystem::directory_iterator(stateRegionsDirectory)) {
+		if (!entry.is_regular_file() || entry.path().extension() != ".txt")
+			continue;
+
+		const auto text = readText(entry.path());
+		forEachProvinceIn(tokenize(text), "provinces", 1, [&](std::string_view state, uint32_t colour) {
+			_provinceStates.emplace(colour, std::string(state));
+		});
+	}
+}
+
+std::vector<std::optional<uint32_t>> ProvinceMap::locateAnchors(const SplineNetwork::AnchorMap &anchors) const {
+	struct Lookup {
+		size_t pixelIndex;
+		uint32_t anchorIndex;
+	};
+
+	std::vector<std::optional<uint32_t>> provinces(anchors.size());
+	std::vector<Lookup> lookups;
+	lookups.reserve(anchors.size());
+	uint32_t anchorIndex = 0;
+	for (const auto &anchor : anchors | std::views::values) {
+		// Anchor positions have (0,0) at the bottom left, images at the top left
+		const auto x = static_cast<int64_t>(std::floor(anchor.posX()));
+		const auto y = static_cast<int64_t>(_image.height()) - 1 - static_cast<int64_t>(std::floor(anchor.posY()));
+		if (x >= 0 && y >= 0 && x < _image.width() && y < _image.height())
+			lookups.push_back({static_cast<size_t>(y) * _image.width() + static_cast<size_t>(x), anchorIndex});
+		++anchorIndex;
+	}
+
+	std::ranges::sort(lookups, {}, &Lookup::pixelIndex);
+	for (const auto &[pixelIndex, index] : lookups) {
+		const auto [r, g, b] = _image.pixel(pixelIndex % _image.width(), pixelIndex / _image.width());
+		provinces[index] = uint32_t(r) << 16 | uint32_t(g) << 8 | b;
+	}
+
+	return provinces;
+}
+
+std::optional<std::string> ProvinceMap::state(uint32_t colour) const {
+	auto it = _provinceStates.find(colour);
+	if (it == _provinceStates.end())
+		return std::nullopt;
+	return it->second;
+}
+
+std::string ProvinceMap::colourName(uint32_t colour) { return fmt::format("x{:06X}", colour); }
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "../Image/Image.hpp"
+#include "../SplineNetwork/SplineNetwork.hpp"
+
+/// provinces.png, where every province is identified by a unique colour
+/// Colours are stored as 0xRRGGBB, and printed like the game files, "x1A2B3C"
+class ProvinceMap {
+	Image _image;
+	std::unordered_set<uint32_t> _waterProvinces;
+	std::unordered_map<uint32_t, std::string> _provinceStates;
+
+public:
+	explicit ProvinceMap(const std::filesystem::path &provincesPath);
+
+	/// Read the sea_starts and lakes from map_data/default.map
+	void loadDefaultMap(const std::filesystem::path &defaultMapPath);
+	/// Read which state every province belongs to from the files in common/history/state_regions
+	void loadStateRegions(const std::filesystem::path &stateRegionsDirectory);
+
+	/// Find the province colour under every anchor, in the same order as `anchors`, or nullopt if it is outside the map
+	/// All lookups are sorted by their position in the image first, so it is read front to back exactly once
+	[[nodiscard]] std::vector<std::optional<uint32_t>> locateAnchors(const SplineNetwork::AnchorMap &anchors) const;
+
+	[[nodiscard]] bool isWater(uint32_t colour) const { return _waterProvinces.contains(colour); }
+	[[nodiscard]] bool hasStates() const { return !_provinceStates.empty(); }
+	/// The state containing the province, or nullopt if no state region mentions it
+	[[nodiscard]] std::optional<std::string> state(uint32_t colour) const;
+
+	static std::string colourName(uint32_t colour);
+};
@@ -0,0 +1,277 @@
+#include "NetworkRenderer.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <ranges>
+#include <thread>
+
+namespace {
+	constexpr uint32_t tileSize = 128;
+
+	constexpr Colour unlinkedColour = {128, 128, 128};
+	constexpr Colour hubColour = {255, 255, 255};
+	constexpr Colour subAnchorColour = {160, 160, 160};
+
+	constexpr Colour unchangedColour = {90, 90, 90};
+	constexpr Colour addedColour = {60, 220, 60};
+	constexpr Colour deletedColour = {230, 50, 50};
+	constexpr Colour editedColour = {240, 210, 40};
+
+	Colour typeColour(Strip::Type type) {
+		switch (type) {
+		case Strip::Type::DIRT_ROAD:       return {214, 160, 90};
+		case Strip::Type::RAILROAD:        return {235, 235, 235};
+		case Strip::Type::SEA_CONNECTION:  return {70, 140, 255};
+		case Strip::Type::PORT_CONNECTION: return {60, 220, 220};
+		}
+		return unlinkedColour;
+	}
+
+	struct Point {
+		float x, y;
+	};
+
+	/// Evaluate a Catmull-Rom spline between p1 and p2
+	Point catmullRom(Point p0, Point p1, Point p2, Point p3, float t) {
+		const float t2 = t * t;
+		const float t3 = t2 * t;
+		auto axis = [&](float a, float b, float c, float d) {
+			return 0.5f * (2 * b + (-a + c) * t + (2 * a - 5 * b + 4 * c - d) * t2 + (-a + 3 * b - 3 * c + d) * t3);
+		};
+		return {axis(p0.x, p1.x, p2.x, p3.x), axis(p0.y, p1.y, p2.y, p3.y)};
+	}
+
+	void blend(Image &image, uint32_t x, uint32_t y, Colour colour, float alpha) {
+		if (alpha >= 1.0f) {
+			image.pixel(x, y, colour);
+			return;
+		}
+		const auto old = image.pixel(x, y);
+		auto mix = [&](uint8_t a, uint8_t b) { return static_cast<uint8_t>(std::lround(a + (b - a) * alpha)); };
+		image.pixel(x, y, {mix(old.r, colour.r), mix(old.g, colour.g), mix(old.b, colour.b)});
+	}
+
+	/// The range of pixels or tiles a bounding box covers, clamped to [0, limit)
+	std::pair<uint32_t, uint32_t> span(float min, float max, uint32_t scale, uint32_t limit) {
+		const auto first = static_cast<int64_t>(std::floor(min / static_cast<float>(scale)));
+		const auto last = static_cast<int64_t>(std::floor(max / static_cast<float>(scale)));
+		return {static_cast<uint32_t>(std::clamp<int64_t>(first, 0, limit)),
+		        static_cast<uint32_t>(std::clamp<int64_t>(last + 1, 0, limit))};
+	}
+} // namespace
+
+NetworkRenderer::NetworkRenderer(uint32_t width, uint32_t height)
+    : _width(width)
+    , _height(height) {}
+
+void NetworkRenderer::addRoute(const Route &route, const SplineNetwork::AnchorMap &anchors, Colour colour,
+                               float halfWidth) {
+	std::vector<Point> points;
+	points.reserve(route.anchors().size());
+	for (const auto id : route.anchors()) {
+		auto it = anchors.find(id);
+		if (it == anchors.end())
+			continue;
+		// Anchor positions have (0,0) at the bottom left, images at the top left
+		points.push_back({it->second.posX(), static_cast<float>(_height) - it->second.posY()});
+	}
+	if (points.size() < 2)
+		return;
+
+	const auto last = points.size() - 1;
+	for (size_t i = 0; i < last; ++i) {
+		const auto &p0 = points[i == 0 ? 0 : i - 1];
+		const auto &p1 = points[i];
+		const auto &p2 = points[i + 1];
+		const auto &p3 = points[std::min(i + 2, last)];
+
+		// Roughly one line segment every few pixels is plenty to look smooth
+		const float length = std::hypot(p2.x - p1.x, p2.y - p1.y);
+		const int samples = std::max(1, static_cast<int>(std::ceil(length / 4.0f)));
+
+		Point previous = p1;
+		for (int s = 1; s <= samples; ++s) {
+			const auto next = catmullRom(p0, p1, p2, p3, static_cast<float>(s) / static_cast<float>(samples));
+			_segments.push_back({previous.x, previous.y, next.x, next.y, halfWidth, colour});
+			previous = next;
+		}
+	}
+}
+void NetworkRenderer::addAnchor(const Anchor &anchor, Colour colour) {
+	_dots.push_back({anchor.posX(), static_cast<float>(_height) - anchor.posY(), anchor.isSubAnchor() ? 1.0f : 2.5f,
+	                 colour});
+}
+
+void NetworkRenderer::addNetwork(const SplineNetwork &network) {
+	std::map<uint64_t, Strip::Type> routeTypes;
+	for (const auto &strip : network.strips() | std::views::values) {
+		for (const auto routeID : strip.routeIDs())
+			routeTypes.emplace(routeID, strip.type());
+	}
+
+	for (const auto &[id, route] : network.routes()) {
+		auto it = routeTypes.find(id);
+		if (it == routeTypes.end()) {
+			addRoute(route, network.anchors(), unlinkedColour, 1.0f);
+			continue;
+		}
+		addRoute(route, network.anchors(), typeColour(it->second), it->second == Strip::Type::RAILROAD ? 1.5f : 1.0f);
+	}
+
+	for (const auto &anchor : network.anchors() | std::views::values)
+		addAnchor(anchor, anchor.isSubAnchor() ? subAnchorColour : hubColour);
+}
+
+void NetworkRenderer::addDiff(const SplineNetwork &base, const SplineNetwork &edited) {
+	const auto diff = base.calculateDiff(edited);
+
+	enum class Status { UNCHANGED, EDITED, ADDED };
+	std::map<uint64_t, Status> routeStatus;
+	auto mark = [&](uint64_t routeID, Status status) {
+		auto &current = routeStatus[routeID];
+		current = std::max(current, status);
+	};
+
+	for (const auto &[id, route] : edited.routes()) {
+		// Moving an anchor changes the shape of every route through it
+		const bool anchorMoved = std::ranges::any_of(
+		    route.anchors(), [&](const auto anchorID) { return diff.anchorChanges.edits.contains(anchorID); });
+		mark(id, anchorMoved ? Status::EDITED : Status::UNCHANGED);
+	}
+	for (const auto &id : diff.routeChanges.edits | std::views::keys)
+		mark(id, Status::EDITED);
+	for (const auto &id : diff.routeChanges.additions | std::views::keys)
+		mark(id, Status::ADDED);
+	for (const auto &[oldStrip, newStrip] : diff.stripChanges.edits | std::views::values) {
+		for (const auto routeID : newStrip.routeIDs())
+			mark(routeID, Status::EDITED);
+	}
+	for (const auto &strip : diff.stripChanges.additions | std::views::values) {
+		for (const auto routeID : strip.routeIDs())
+			mark(routeID, Status::ADDED);
+	}
+
+	// Draw the changes last, so they stay visible on top of the rest of the network
+	auto addRoutes = [&](Status status, Colour colour, float halfWidth) {
+		for (const auto &[id, route] : edited.routes()) {
+			if (routeStatus[id] == status)
+				addRoute(route, edited.anchors(), colour, halfWidth);
+		}
+	};
+	addRoutes(Status::UNCHANGED, unchangedColour, 1.0f);
+	for (const auto &route : diff.routeChanges.deletions | std::views::values)
+		addRoute(route, base.anchors(), deletedColour, 1.5f);
+	addRoutes(Status::EDITED, editedColour, 1.5f);
+	addRoutes(Status::ADDED, addedColour, 1.5f);
+
+	for (const auto &[id, anchor] : edited.anchors()) {
+		if (!diff.anchorChanges.edits.contains(id) && !diff.anchorChanges.additions.contains(id))
+			addAnchor(anchor, unchangedColour);
+	}
+	for (const auto &anchor : diff.anchorChanges.deletions | std::views::values)
+		addAnchor(anchor, deletedColour);
+	for (const auto &[oldAnchor, newAnchor] : diff.anchorChanges.edits | std::views::values)
+		addAnchor(newAnchor, editedColour);
+	for (const auto &anchor : diff.anchorChanges.additions | std::views::values)
+		addAnchor(anchor, addedColour);
+}
+
+void NetworkRenderer::render(Image &image, unsigned threadCount) const {
+	if (image.width() != _width || image.height() != _height) {
+		throw std::runtime_error(fmt::format("Image is {}x{}, but the renderer expects {}x{}", image.width(),
+		                                     image.height(), _width, _height));
+	}
+
+	const uint32_t tilesX = (_width + tileSize - 1) / tileSize;
+	const uint32_t tilesY = (_height + tileSize - 1) / tileSize;
+
+	// Bin every primitive into the tiles its bounding box touches, keeping the drawing order within each tile
+	std::vector<std::vector<uint32_t>> segmentBins(static_cast<size_t>(tilesX) * tilesY);
+	std::vector<std::vector<uint32_t>> dotBins(segmentBins.size());
+	auto bin = [&](auto &bins, uint32_t index, float minX, float minY, float maxX, float maxY) {
+		const auto [firstX, lastX] = span(minX, maxX, tileSize, tilesX);
+		const auto [firstY, lastY] = span(minY, maxY, tileSize, tilesY);
+		for (uint32_t ty = firstY; ty < lastY; ++ty) {
+			for (uint32_t tx = firstX; tx < lastX; ++tx)
+				bins[ty * tilesX + tx].push_back(index);
+		}
+	};
+	for (uint32_t i = 0; i < _segments.size(); ++i) {
+		const auto &s = _segments[i];
+		const float reach = s.halfWidth + 1;
+		bin(segmentBins, i, std::min(s.x0, s.x1) - reach, std::min(s.y0, s.y1) - reach, std::max(s.x0, s.x1) + reach,
+		    std::max(s.y0, s.y1) + reach);
+	}
+	for (uint32_t i = 0; i < _dots.size(); ++i) {
+		const auto &d = _dots[i];
+		const float reach = d.radius + 1;
+		bin(dotBins, i, d.x - reach, d.y - reach, d.x + reach, d.y + reach);
+	}
+
+	// Each tile owns its pixels, so the threads never touch the same part of the image
+	auto renderTile = [&](uint32_t tile) {
+		const uint32_t tileX = tile % tilesX * tileSize;
+		const uint32_t tileY = tile / tilesX * tileSize;
+		const uint32_t tileEndX = std::min(tileX + tileSize, _width);
+		const uint32_t tileEndY = std::min(tileY + tileSize, _height);
+
+		auto clampedSpan = [](float min, float max, uint32_t first, uint32_t end) {
+			auto [from, to] = span(min, max, 1, end);
+			return std::pair(std::max(from, first), to);
+		};
+
+		for (const auto index : segmentBins[tile]) {
+			const auto &s = _segments[index];
+			const float reach = s.halfWidth + 1;
+			const auto [fromX, toX] = clampedSpan(std::min(s.x0, s.x1) - reach, std::max(s.x0, s.x1) + reach, tileX,
+			                                      tileEndX);
+			const auto [fromY, toY] = clampedSpan(std::min(s.y0, s.y1) - reach, std::max(s.y0, s.y1) + reach, tileY,
+			                                      tileEndY);
+
+			const float dx = s.x1 - s.x0;
+			const float dy = s.y1 - s.y0;
+			const float lengthSquared = dx * dx + dy * dy;
+			for (uint32_t y = fromY; y < toY; ++y) {
+				for (uint32_t x = fromX; x < toX; ++x) {
+					// Distance from the pixel centre to the closest point on the segment
+					const float px = static_cast<float>(x) + 0.5f - s.x0;
+					const float py = static_cast<float>(y) + 0.5f - s.y0;
+					const float t = lengthSquared > 0 ? std::clamp((px * dx + py * dy) / lengthSquared, 0.0f, 1.0f) : 0;
+					const float distance = std::hypot(px - t * dx, py - t * dy);
+
+					const float coverage = std::min(1.0f, s.halfWidth + 0.5f - distance);
+					if (coverage > 0)
+						blend(image, x, y, s.colour, coverage);
+				}
+			}
+		}
+		for (const auto index : dotBins[tile]) {
+			const auto &d = _dots[index];
+			const float reach = d.radius + 1;
+			const auto [fromX, toX] = clampedSpan(d.x - reach, d.x + reach, tileX, tileEndX);
+			const auto [fromY, toY] = clampedSpan(d.y - reach, d.y + reach, tileY, tileEndY);
+			for (uint32_t y = fromY; y < toY; ++y) {
+				for (uint32_t x = fromX; x < toX; ++x) {
+					const float distance =
+					    std::hypot(static_cast<float>(x) + 0.5f - d.x, static_cast<float>(y) + 0.5f - d.y);
+					const float coverage = std::min(1.0f, d.radius + 0.5f - distance);
+					if (coverage > 0)
+						blend(image, x, y, d.colour, coverage);
+				}
+			}
+		}
+	};
+
+	std::atomic<uint32_t> nextTile = 0;
+	const auto tileCount = static_cast<uint32_t>(segmentBins.size());
+	{
+		std::vector<std::jthread> threads;
+		for (unsigned i = 0; i < std::max(1u, threadCount); ++i) {
+			threads.emplace_back([&] {
+				for (auto tile = nextTile++; tile < tileCount; tile = nextTile++)
+					renderTile(tile);
+			});
+		}
+	}
+}
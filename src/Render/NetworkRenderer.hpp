@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "../Image/Image.hpp"
+#include "../SplineNetwork/SplineNetwork.hpp"
+
+/// Rasterizes spline networks onto an image with the same dimensions as provinces.png
+/// Everything is first turned into line segments and dots, which are binned into tiles rendered in parallel
+class NetworkRenderer {
+	struct Segment {
+		float x0, y0, x1, y1;
+		float halfWidth;
+		Colour colour;
+	};
+	struct Dot {
+		float x, y;
+		float radius;
+		Colour colour;
+	};
+
+	uint32_t _width;
+	uint32_t _height;
+	std::vector<Segment> _segments;
+	std::vector<Dot> _dots;
+
+	void addRoute(const Route &route, const SplineNetwork::AnchorMap &anchors, Colour colour, float halfWidth);
+	void addAnchor(const Anchor &anchor, Colour colour);
+
+public:
+	NetworkRenderer(uint32_t width, uint32_t height);
+
+	/// Draw the entire network, with routes coloured by the type of their strip
+	void addNetwork(const SplineNetwork &network);
+	/// Draw `edited` with the changes compared to `base` highlighted,
+	/// additions in green, deletions in red and edits in yellow
+	void addDiff(const SplineNetwork &base, const SplineNetwork &edited);
+
+	/// Draw everything added so far on top of `image`, which has to be the same size as the renderer
+	void render(Image &image, unsigned threadCount) const;
+};
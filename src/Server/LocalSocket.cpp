@@ -0,0 +1,198 @@
+#include "LocalSocket.hpp"
+
+#include <cstring>
+#include <system_error>
+#include <utility>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <afunix.h>
+#include <windows.h>
+#else
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include <fmt/format.h>
+
+namespace {
+	sockaddr_un socketAddress(const std::filesystem::path &path) {
+		sockaddr_un address{};
+		address.sun_family = AF_UNIX;
+		const auto pathString = path.string();
+		if (pathString.size() >= sizeof(address.sun_path))
+			throw std::runtime_error(fmt::format("Socket path \"{}\" is too long", pathString));
+		std::memcpy(address.sun_path, pathString.c_str(), pathString.size() + 1);
+		return address;
+	}
+#ifdef _WIN32
+	std::system_error socketError(std::string_view what) {
+		return {WSAGetLastError(), std::system_category(), std::string(what)};
+	}
+	/// Winsock has to be started before any socket is created
+	void startWinsock() {
+		static const bool started = [] {
+			WSADATA data;
+			return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+		}();
+		if (!started)
+			throw std::runtime_error("Could not start Winsock");
+	}
+	/// std::filesystem never reports AF_UNIX sockets on Windows, they are reparse points with their own tag
+	bool isSocketFile(const std::filesystem::path &path) {
+#ifndef IO_REPARSE_TAG_AF_UNIX
+		constexpr DWORD IO_REPARSE_TAG_AF_UNIX = 0x8000'0023;
+#endif
+		WIN32_FIND_DATAW data;
+		const auto find = FindFirstFileW(path.c_str(), &data);
+		if (find == INVALID_HANDLE_VALUE)
+			return false;
+		FindClose(find);
+		return (data.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) && data.dwReserved0 == IO_REPARSE_TAG_AF_UNIX;
+	}
+	/// Whether a server is accepting connections on `address`
+	bool isListening(const sockaddr_un &address) {
+		const auto probe = ::socket(AF_UNIX, SOCK_STREAM, 0);
+		if (probe == INVALID_SOCKET)
+			return false;
+		const auto connected = ::connect(probe, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) == 0;
+		::closesocket(probe);
+		return connected;
+	}
+#else
+	std::system_error socketError(std::string_view what) {
+		return {errno, std::generic_category(), std::string(what)};
+	}
+	bool isSocketFile(const std::filesystem::path &path) {
+		return std::filesystem::is_socket(std::filesystem::symlink_status(path));
+	}
+	/// Whether a server is accepting connections on `address`
+	bool isListening(const sockaddr_un &address) {
+		const auto probe = ::socket(AF_UNIX, SOCK_STREAM, 0);
+		if (probe < 0)
+			return false;
+		const auto connected = ::connect(probe, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) == 0;
+		::close(probe);
+		return connected;
+	}
+#endif
+
+	/// Remove a socket left behind by a previous server
+	/// Anything else at the path is a mistake, and a socket still being listened on belongs to a running server,
+	/// so both are left alone
+	void removeStaleSocket(const std::filesystem::path &path, const sockaddr_un &address) {
+		if (!std::filesystem::exists(std::filesystem::symlink_status(path)))
+			return;
+		if (!isSocketFile(path))
+			throw std::runtime_error(fmt::format("\"{}\" exists and is not a socket", path.string()));
+		if (isListening(address))
+			throw std::runtime_error(fmt::format("Another server is already listening on \"{}\"", path.string()));
+		std::filesystem::remove(path);
+	}
+} // namespace
+
+#ifdef _WIN32
+LocalSocket LocalSocket::listen(const std::filesystem::path &path) {
+	startWinsock();
+	const auto address = socketAddress(path);
+	removeStaleSocket(path, address);
+
+	LocalSocket listener;
+	listener._socket = ::socket(AF_UNIX, SOCK_STREAM, 0);
+	if (listener._socket == INVALID_SOCKET)
+		throw socketError("Could not create socket");
+	if (::bind(listener._socket, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0 ||
+	    ::listen(listener._socket, SOMAXCONN) != 0)
+		throw socketError(fmt::format("Could not listen on \"{}\"", path.string()));
+	return listener;
+}
+LocalSocket LocalSocket::accept() const {
+	LocalSocket client;
+	client._socket = ::accept(_socket, nullptr, nullptr);
+	if (client._socket == INVALID_SOCKET)
+		throw socketError("Could not accept connection");
+	return client;
+}
+void LocalSocket::close() {
+	if (_socket != INVALID_SOCKET)
+		::closesocket(_socket);
+	_socket = INVALID_SOCKET;
+}
+#else
+LocalSocket LocalSocket::listen(const std::filesystem::path &path) {
+	const auto address = socketAddress(path);
+	removeStaleSocket(path, address);
+
+	LocalSocket listener;
+	listener._socket = ::socket(AF_UNIX, SOCK_STREAM, 0);
+	if (listener._socket < 0)
+		throw socketError("Could not create socket");
+	if (::bind(listener._socket, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0 ||
+	    ::listen(listener._socket, SOMAXCONN) != 0)
+		throw socketError(fmt::format("Could not listen on \"{}\"", path.string()));
+	return listener;
+}
+LocalSocket LocalSocket::accept() const {
+	LocalSocket client;
+	do {
+		client._socket = ::accept(_socket, nullptr, nullptr);
+	} while (client._socket < 0 && errno == EINTR);
+	if (client._socket < 0)
+		throw socketError("Could not accept connection");
+	return client;
+}
+void LocalSocket::close() {
+	if (_socket >= 0)
+		::close(_socket);
+	_socket = -1;
+}
+#endif
+
+LocalSocket::~LocalSocket() { close(); }
+LocalSocket::LocalSocket(LocalSocket &&other) noexcept
+    : _socket(std::exchange(other._socket, decltype(_socket)(-1)))
+    , _buffer(std::move(other._buffer)) {}
+LocalSocket &LocalSocket::operator=(LocalSocket &&other) noexcept {
+	if (this != &other) {
+		close();
+		_socket = std::exchange(other._socket, decltype(_socket)(-1));
+		_buffer = std::move(other._buffer);
+	}
+	return *this;
+}
+
+std::optional<std::string> LocalSocket::readLine() {
+	size_t searchFrom = 0;
+	while (true) {
+		const auto newline = _buffer.find('\n', searchFrom);
+		if (newline != std::string::npos) {
+			auto line = _buffer.substr(0, newline);
+			_buffer.erase(0, newline + 1);
+			return line;
+		}
+		searchFrom = _buffer.size();
+		if (_buffer.size() > maxLineLength)
+			return std::nullopt;
+
+		char chunk[4096];
+		const auto received = ::recv(_socket, chunk, sizeof(chunk), 0);
+		if (received <= 0)
+			return std::nullopt;
+		_buffer.append(chunk, static_cast<size_t>(received));
+	}
+}
+bool LocalSocket::write(std::string_view data) const {
+	while (!data.empty()) {
+#ifdef _WIN32
+		const auto sent = ::send(_socket, data.data(), static_cast<int>(data.size()), 0);
+#else
+		// Don't get killed by SIGPIPE when a client disconnects before reading its answer
+		const auto sent = ::send(_socket, data.data(), data.size(), MSG_NOSIGNAL);
+#endif
+		if (sent <= 0)
+			return false;
+		data.remove_prefix(static_cast<size_t>(sent));
+	}
+	return true;
+}
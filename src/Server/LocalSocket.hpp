@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+
+/// A Unix domain stream socket, either listening on a path or connected to a client
+/// Windows 10 and later support these as well, through Winsock
+class LocalSocket {
+#ifdef _WIN32
+	uintptr_t _socket = ~uintptr_t(0);
+#else
+	int _socket = -1;
+#endif
+	// Received data after the last complete line
+	std::string _buffer;
+
+	void close();
+
+public:
+	LocalSocket() = default;
+	/// Listen on `path`, replacing whatever socket a previous server left behind
+	/// Throws if anything other than a socket is at `path`, or another server is still listening on it
+	static LocalSocket listen(const std::filesystem::path &path);
+	~LocalSocket();
+
+	LocalSocket(const LocalSocket &) = delete;
+	LocalSocket &operator=(const LocalSocket &) = delete;
+	LocalSocket(LocalSocket &&other) noexcept;
+	LocalSocket &operator=(LocalSocket &&other) noexcept;
+
+	/// Wait for the next client to connect
+	[[nodiscard]] LocalSocket accept() const;
+
+	/// Longer lines are treated as a misbehaving client rather than buffered without end
+	static constexpr size_t maxLineLength = 1 << 20;
+
+	/// The next line sent by the other end without the newline
+	/// nullopt once it disconnects or sends a line longer than `maxLineLength`, either way it should be dropped
+	[[nodiscard]] std::optional<std::string> readLine();
+	/// Returns false if the other end has disconnected
+	bool write(std::string_view data) const;
+};
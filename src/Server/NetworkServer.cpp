@@ -0,0 +1,235 @@
+#include "NetworkServer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <mutex>
+#include <ranges>
+#include <thread>
+
+#include <fmt/ostream.h>
+
+using json = nlohmann::json;
+
+NetworkServer::LoadedNetwork::LoadedNetwork(std::filesystem::path networkPath)
+    : path(std::move(networkPath))
+    , network(path) {
+	for (const auto &anchor : network.anchors() | std::views::values)
+		grid.insert(anchor);
+
+	for (const auto &[id, route] : network.routes()) {
+		for (const auto anchorID : route.anchors()) {
+			auto &routes = anchorRoutes[anchorID];
+			// Routes sometimes pass through the same anchor twice
+			if (routes.empty() || routes.back() != id)
+				routes.push_back(id);
+		}
+	}
+	for (const auto &[key, strip] : network.strips()) {
+		anchorStrips[strip.sourceID()].push_back(key);
+		if (strip.destinationID() != strip.sourceID())
+			anchorStrips[strip.destinationID()].push_back(key);
+		for (const auto routeID : strip.routeIDs())
+			routeStrips[static_cast<uint32_t>(routeID)].push_back(key);
+	}
+}
+
+void NetworkServer::load(std::string name, const std::filesystem::path &path) {
+	auto loaded = std::make_shared<const LoadedNetwork>(path);
+	std::unique_lock lock(_mutex);
+	_networks.insert_or_assign(std::move(name), std::move(loaded));
+}
+
+const NetworkServer::LoadedNetwork &NetworkServer::network(const json &request) const {
+	if (!request.contains("network")) {
+		if (_networks.size() != 1)
+			throw std::runtime_error("More than one network is loaded, pick one with \"network\"");
+		return *_networks.begin()->second;
+	}
+
+	const auto name = request["network"].get<std::string>();
+	auto it = _networks.find(name);
+	if (it == _networks.end())
+		throw std::runtime_error(fmt::format("No network named \"{}\" is loaded", name));
+	return *it->second;
+}
+
+json NetworkServer::list() const {
+	json result = json::object();
+	for (const auto &[name, loaded] : _networks) {
+		result[name] = {{"path", loaded->path.string()},
+		                {"anchors", loaded->network.anchors().size()},
+		                {"routes", loaded->network.routes().size()},
+		                {"strips", loaded->network.strips().size()}};
+	}
+	return result;
+}
+json NetworkServer::lookup(const json &request) const {
+	const auto &loaded = network(request);
+	const auto &network = loaded.network;
+	auto strips = [&](const auto &index, uint32_t id, auto include) {
+		json found = json::array();
+		if (auto it = index.find(id); it != index.end()) {
+			for (const auto &key : it->second) {
+				const auto &strip = network.strips().at(key);
+				if (include(strip))
+					found.push_back(strip);
+			}
+		}
+		return found;
+	};
+	auto anyStrip = [](const Strip &) { return true; };
+
+	if (request.contains("anchor")) {
+		const auto id = request["anchor"].get<uint32_t>();
+		auto it = network.anchors().find(id);
+		if (it == network.anchors().end())
+			throw std::runtime_error(fmt::format("Anchor {:#x} not found", id));
+
+		const auto routes = loaded.anchorRoutes.find(id);
+		return {{"anchor", it->second},
+		        {"routes", routes != loaded.anchorRoutes.end() ? routes->second : std::vector<uint32_t>()},
+		        {"strips", strips(loaded.anchorStrips, id, anyStrip)}};
+	}
+	if (request.contains("route")) {
+		const auto id = request["route"].get<uint32_t>();
+		auto it = network.routes().find(id);
+		if (it == network.routes().end())
+			throw std::runtime_error(fmt::format("Route {:#x} not found", id));
+
+		return {{"route", it->second}, {"strips", strips(loaded.routeStrips, id, anyStrip)}};
+	}
+	if (request.contains("strip")) {
+		const auto [source, destination] = request["strip"].get<std::pair<uint32_t, uint32_t>>();
+		auto found = strips(loaded.anchorStrips, source, [&](const Strip &strip) {
+			return strip.sourceID() == source && strip.destinationID() == destination;
+		});
+		if (found.empty())
+			throw std::runtime_error(fmt::format("Strip {}->{} not found", source, destination));
+		return {{"strips", std::move(found)}};
+	}
+	throw std::runtime_error("lookup needs an \"anchor\", \"route\", or \"strip\"");
+}
+json NetworkServer::nearby(const json &request) const {
+	const auto &loaded = network(request);
+	const auto x = request.at("x").get<float>();
+	const auto y = request.at("y").get<float>();
+	const auto radius = request.value("radius", 10.0f);
+	const auto limit = request.value("limit", size_t(100));
+	const auto hubsOnly = request.value("hubs", false);
+	// Keeps the grid's cell indices in range, maps are a few thousand pixels across
+	constexpr float maxCoordinate = 1'000'000;
+	constexpr float maxRadius = 10'000;
+	if (!std::isfinite(x) || !std::isfinite(y) || std::abs(x) > maxCoordinate || std::abs(y) > maxCoordinate)
+		throw std::runtime_error(fmt::format("Position must be within ±{} on both axes", maxCoordinate));
+	if (!(radius >= 0 && radius <= maxRadius))
+		throw std::runtime_error(fmt::format("Radius must be between 0 and {}", maxRadius));
+
+	json result = json::array();
+	for (const auto &[id, distance] : loaded.grid.near(x, y, radius)) {
+		if (result.size() == limit)
+			break;
+		const auto &anchor = loaded.network.anchors().at(id);
+		if (hubsOnly && anchor.isSubAnchor())
+			continue;
+		result.push_back({{"anchor", anchor}, {"distance", distance}});
+	}
+	return result;
+}
+json NetworkServer::diff(const json &request) const {
+	// Parse before taking the lock, reloads shouldn't have to wait for it
+	const SplineNetwork other(std::filesystem::path(request.at("file").get<std::string>()));
+	std::shared_lock lock(_mutex);
+	const auto diff = network(request).network.calculateDiff(other);
+	lock.unlock();
+
+	if (!request.value("summary", false))
+		return diff;
+
+	auto counts = [](const auto &changes) {
+		return json{{"additions", changes.additions.size()},
+		            {"deletions", changes.deletions.size()},
+		            {"edits", changes.edits.size()}};
+	};
+	return {{"anchorChanges", counts(diff.anchorChanges)},
+	        {"stripChanges", counts(diff.stripChanges)},
+	        {"routeChanges", counts(diff.routeChanges)}};
+}
+json NetworkServer::reload(const json &request) {
+	std::string name;
+	std::filesystem::path path;
+	{
+		std::shared_lock lock(_mutex);
+		const auto &loaded = network(request);
+		name = std::ranges::find(_networks, &loaded, [](const auto &item) { return item.second.get(); })->first;
+		path = request.contains("file") ? std::filesystem::path(request["file"].get<std::string>()) : loaded.path;
+	}
+
+	// Parse without holding any lock, so queries keep being answered from the old version meanwhile
+	load(name, path);
+
+	std::shared_lock lock(_mutex);
+	return list()[name];
+}
+
+json NetworkServer::handle(const json &request) {
+	json response;
+	if (request.contains("id"))
+		response["id"] = request["id"];
+
+	try {
+		const auto command = request.at("command").get<std::string>();
+		// These parse files, and only lock once they're done
+		if (command == "reload") {
+			response["result"] = reload(request);
+		} else if (command == "diff") {
+			response["result"] = diff(request);
+		} else {
+			std::shared_lock lock(_mutex);
+			if (command == "list")
+				response["result"] = list();
+			else if (command == "lookup")
+				response["result"] = lookup(request);
+			else if (command == "nearby")
+				response["result"] = nearby(request);
+			else
+				throw std::runtime_error(fmt::format("Unknown command \"{}\"", command));
+		}
+		response["ok"] = true;
+	} catch (const std::exception &err) {
+		response["ok"] = false;
+		response["error"] = err.what();
+	}
+	return response;
+}
+
+void NetworkServer::serveClient(LocalSocket client) {
+	while (const auto line = client.readLine()) {
+		if (line->find_first_not_of(" \t\r") == std::string::npos)
+			continue;
+
+		// Nothing a client sends may escape this thread, that would take down the whole server
+		std::string response;
+		try {
+			// Error messages can quote invalid UTF-8 from the request, which a strict dump throws on
+			response = handle(json::parse(*line)).dump(-1, ' ', false, json::error_handler_t::replace);
+		} catch (const std::exception &err) {
+			response = json{{"ok", false}, {"error", err.what()}}.dump(-1, ' ', false, json::error_handler_t::replace);
+		}
+		if (!client.write(response + '\n'))
+			return;
+	}
+}
+void NetworkServer::serve(const std::filesystem::path &socketPath) {
+	const auto listener = LocalSocket::listen(socketPath);
+	fmt::print("Listening on \"{}\"\n", socketPath.string());
+
+	while (true) {
+		try {
+			// Clients come and go, the server itself never stops, so nothing needs to wait for their threads
+			std::thread([this, client = listener.accept()]() mutable { serveClient(std::move(client)); }).detach();
+		} catch (const std::system_error &err) {
+			fmt::print(std::cerr, "{}\n", err.what());
+		}
+	}
+}
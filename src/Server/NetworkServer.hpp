@@ -0,0 +1,57 @@
+#pragma once
+
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "LocalSocket.hpp"
+#include "../SplineNetwork/AnchorGrid.hpp"
+#include "../SplineNetwork/SplineNetwork.hpp"
+
+/// Keeps networks in memory and answers queries about them, one JSON object per line, from any number of clients
+/// Queries share a read lock, reloads only take the write lock to swap in the already parsed network
+class NetworkServer {
+	/// A network along with the indices the queries need
+	struct LoadedNetwork {
+		std::filesystem::path path;
+		SplineNetwork network;
+		AnchorGrid grid;
+		/// The routes using every anchor, and the strips starting or ending at every hub anchor
+		std::unordered_map<uint32_t, std::vector<uint32_t>> anchorRoutes;
+		std::unordered_map<uint32_t, std::vector<SplineNetwork::StripMap::key_type>> anchorStrips;
+		/// The strips containing every route
+		std::unordered_map<uint32_t, std::vector<SplineNetwork::StripMap::key_type>> routeStrips;
+
+		explicit LoadedNetwork(std::filesystem::path networkPath);
+	};
+
+	std::map<std::string, std::shared_ptr<const LoadedNetwork>> _networks;
+	mutable std::shared_mutex _mutex;
+
+	/// The network a request is about, the only one if it doesn't name any
+	[[nodiscard]] const LoadedNetwork &network(const nlohmann::json &request) const;
+
+	[[nodiscard]] nlohmann::json list() const;
+	[[nodiscard]] nlohmann::json lookup(const nlohmann::json &request) const;
+	[[nodiscard]] nlohmann::json nearby(const nlohmann::json &request) const;
+	[[nodiscard]] nlohmann::json diff(const nlohmann::json &request) const;
+	nlohmann::json reload(const nlohmann::json &request);
+
+	void serveClient(LocalSocket client);
+
+public:
+	/// Load a network to be queried as `name`
+	void load(std::string name, const std::filesystem::path &path);
+
+	/// Answer a single request, errors are returned in the response rather than thrown
+	[[nodiscard]] nlohmann::json handle(const nlohmann::json &request);
+
+	/// Accept clients on the socket until the process is stopped, each one served on its own thread
+	[[noreturn]] void serve(const std::filesystem::path &socketPath);
+};
@@ -28,6 +28,11 @@ public:
 	/// The id without the signaling bits, as entered in the editor
 	[[nodiscard]] auto niceID() const { return _id & ((1 << 23) - 1); }
 
+	[[nodiscard]] auto posX() const { return _posX; }
+	[[nodiscard]] auto posY() const { return _posY; }
+	void posX(float set) { _posX = set; }
+	void posY(float set) { _posY = set; }
+
 	bool operator==(const Anchor &other) const = default;
 
 	NLOHMANN_DEFINE_TYPE_INTRUSIVE(Anchor, _id, _posX, _posY);
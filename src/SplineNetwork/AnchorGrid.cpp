@@ -0,0 +1,50 @@
+#include "AnchorGrid.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <ranges>
+
+AnchorGrid::AnchorGrid(float cellSize)
+    : _cellSize(cellSize) {}
+
+int32_t AnchorGrid::cell(float position) const { return static_cast<int32_t>(std::floor(position / _cellSize)); }
+uint64_t AnchorGrid::key(int32_t x, int32_t y) {
+	return static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32 | static_cast<uint32_t>(y);
+}
+
+void AnchorGrid::insert(const Anchor &anchor) {
+	_cells[key(cell(anchor.posX()), cell(anchor.posY()))].push_back({anchor.id(), anchor.posX(), anchor.posY()});
+	_size++;
+}
+
+std::vector<AnchorGrid::Match> AnchorGrid::near(float x, float y, float radius) const {
+	std::vector<Match> matches;
+	auto check = [&](const std::vector<Entry> &entries) {
+		for (const auto &entry : entries) {
+			const auto distance = std::hypot(entry.x - x, entry.y - y);
+			if (distance <= radius)
+				matches.push_back({entry.id, distance});
+		}
+	};
+
+	const auto minX = cell(x - radius);
+	const auto maxX = cell(x + radius);
+	const auto minY = cell(y - radius);
+	const auto maxY = cell(y + radius);
+	// Past a point it's cheaper to check every occupied cell than to look up every cell in range
+	if (static_cast<double>(maxX - minX + 1) * (maxY - minY + 1) > static_cast<double>(_cells.size())) {
+		for (const auto &entries : _cells | std::views::values)
+			check(entries);
+	} else {
+		for (auto cellX = minX; cellX <= maxX; ++cellX) {
+			for (auto cellY = minY; cellY <= maxY; ++cellY) {
+				auto it = _cells.find(key(cellX, cellY));
+				if (it != _cells.end())
+					check(it->second);
+			}
+		}
+	}
+
+	std::ranges::sort(matches, {}, &Match::distance);
+	return matches;
+}
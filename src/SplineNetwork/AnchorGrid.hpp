@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "Anchor.hpp"
+
+/// A spatial hash of anchor positions, for finding the anchors near a point without checking every one of them
+class AnchorGrid {
+public:
+	struct Entry {
+		uint32_t id;
+		float x;
+		float y;
+	};
+	struct Match {
+		uint32_t id;
+		float distance;
+	};
+
+private:
+	float _cellSize;
+	size_t _size = 0;
+	std::unordered_map<uint64_t, std::vector<Entry>> _cells;
+
+	[[nodiscard]] int32_t cell(float position) const;
+	static uint64_t key(int32_t x, int32_t y);
+
+public:
+	/// Smaller cells make searches with a small radius faster, and large ones slower
+	explicit AnchorGrid(float cellSize = 32);
+
+	void insert(const Anchor &anchor);
+
+	[[nodiscard]] size_t size() const { return _size; }
+	/// Every anchor within `radius` of the point, closest first
+	[[nodiscard]] std::vector<Match> near(float x, float y, float radius) const;
+};
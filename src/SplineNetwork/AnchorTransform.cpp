@@ -0,0 +1,82 @@
+#include "AnchorTransform.hpp"
+
+#include <ranges>
+#include <vector>
+
+#include "SimdFloat.hpp"
+
+namespace {
+	/// values[i] * scale + offset for [begin, end) `V::width` at a time
+	/// `end - begin` has to be a multiple of the width
+	template <typename V> void scaleAndOffset(float *values, size_t begin, size_t end, float scale, float offset) {
+		const auto s = V::broadcast(scale);
+		const auto o = V::broadcast(offset);
+		for (size_t i = begin; i < end; i += V::width)
+			(V::load(&values[i]) * s + o).store(&values[i]);
+	}
+	void scaleAndOffset(std::vector<float> &values, float scale, float offset) {
+		const auto vectorEnd = values.size() - values.size() % simd::FloatN::width;
+		scaleAndOffset<simd::FloatN>(values.data(), 0, vectorEnd, scale, offset);
+		scaleAndOffset<simd::Float1>(values.data(), vectorEnd, values.size(), scale, offset);
+	}
+} // namespace
+
+AnchorTransform::AnchorTransform(float scaleX, float scaleY, float offsetX, float offsetY)
+    : _scaleX(scaleX)
+    , _scaleY(scaleY)
+    , _offsetX(offsetX)
+    , _offsetY(offsetY) {}
+
+bool AnchorTransform::selects(const Anchor &anchor) const {
+	if (_bounds && !_bounds->contains(anchor))
+		return false;
+
+	switch (_anchorClass) {
+	case AnchorClass::All:
+		return true;
+	case AnchorClass::Hub:
+		return !anchor.isSubAnchor();
+	case AnchorClass::Sub:
+		return anchor.isSubAnchor();
+	case AnchorClass::Land:
+		return !anchor.isWaterAnchor();
+	case AnchorClass::Water:
+		return anchor.isWaterAnchor();
+	}
+	return false;
+}
+
+Diff AnchorTransform::transform(const SplineNetwork &network) const {
+	// The selected anchors, and their positions back to back
+	std::vector<const Anchor *> selected;
+	std::vector<float> x;
+	std::vector<float> y;
+	selected.reserve(network.anchors().size());
+	x.reserve(network.anchors().size());
+	y.reserve(network.anchors().size());
+	for (const auto &anchor : network.anchors() | std::views::values) {
+		if (!selects(anchor))
+			continue;
+		selected.push_back(&anchor);
+		x.push_back(anchor.posX());
+		y.push_back(anchor.posY());
+	}
+
+	scaleAndOffset(x, _scaleX, _offsetX);
+	scaleAndOffset(y, _scaleY, _offsetY);
+
+	// The anchors are still in id order, so every edit goes at the end of the map
+	Diff diff;
+	auto &edits = diff.anchorChanges.edits;
+	for (size_t i = 0; i < selected.size(); ++i) {
+		const auto &anchor = *selected[i];
+		if (anchor.posX() == x[i] && anchor.posY() == y[i])
+			continue;
+
+		auto moved = anchor;
+		moved.posX(x[i]);
+		moved.posY(y[i]);
+		edits.emplace_hint(edits.end(), anchor.id(), std::pair(anchor, moved));
+	}
+	return diff;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <optional>
+
+#include "Diff.hpp"
+#include "SplineNetwork.hpp"
+
+/// Scales and then moves anchor positions, for following the map when it is resized or shifted
+/// The positions of the selected anchors are gathered into contiguous arrays and transformed with batch kernels
+class AnchorTransform {
+public:
+	/// Which anchors to transform
+	enum class AnchorClass {
+		All,
+		Hub,
+		Sub,
+		Land,
+		Water,
+	};
+	/// Inclusive on all sides, in provinces.png pixels
+	struct Bounds {
+		float minX;
+		float minY;
+		float maxX;
+		float maxY;
+
+		[[nodiscard]] bool contains(const Anchor &anchor) const {
+			return anchor.posX() >= minX && anchor.posX() <= maxX && anchor.posY() >= minY && anchor.posY() <= maxY;
+		}
+	};
+
+private:
+	float _scaleX;
+	float _scaleY;
+	float _offsetX;
+	float _offsetY;
+
+	AnchorClass _anchorClass = AnchorClass::All;
+	std::optional<Bounds> _bounds;
+
+	[[nodiscard]] bool selects(const Anchor &anchor) const;
+
+public:
+	/// Positions become (x * scaleX + offsetX, y * scaleY + offsetY)
+	AnchorTransform(float scaleX, float scaleY, float offsetX, float offsetY);
+
+	/// Only transform anchors of this class
+	void limitTo(AnchorClass anchorClass) { _anchorClass = anchorClass; }
+	/// Only transform anchors within `bounds`, before being transformed
+	void limitTo(const Bounds &bounds) { _bounds = bounds; }
+
+	/// The anchor edits for every selected anchor that moves
+	[[nodiscard]] Diff transform(const SplineNetwork &network) const;
+};
@@ -1,14 +1,36 @@
 #include "Diff.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <ranges>
 #include <set>
 
 #include <fmt/ostream.h>
 
-void Diff::mergeDiff(Diff other) {
-	std::set<uint32_t> reservedAnchorIds;
-	std::set<uint32_t> reservedRouteIds;
+#include "AnchorGrid.hpp"
+#include "RouteDeduplicator.hpp"
+
+Diff::Diff(SplnetFileReader &fileReader) {
+	anchorChanges.readFromFile(fileReader, [](const Anchor &anchor) { return anchor.id(); });
+	stripChanges.readFromFile(fileReader, [](const Strip &strip) { return strip.idPair(); });
+	routeChanges.readFromFile(fileReader, [](const Route &route) { return route.id(); });
+}
+void Diff::writeToFile(SplnetFileWriter &fileWriter) const {
+	anchorChanges.writeToFile(fileWriter);
+	stripChanges.writeToFile(fileWriter);
+	routeChanges.writeToFile(fileWriter);
+}
+
+void Diff::mergeDiff(Diff other, const MergeOptions &options, MergeReport *report) {
+	const auto policy = options.policy;
+	if (options.weldTolerance) {
+		if (const auto welded = other.weldHubAnchors(*this, *options.weldTolerance))
+			fmt::print("Welded {} hub anchors onto ones already merged.\n", welded);
+	}
+
+	ReservedIds reservedAnchorIds;
+	ReservedIds reservedRouteIds;
 	for (const auto &id : anchorChanges.additions | std::views::keys) {
 		reservedAnchorIds.emplace(id);
 	}
@@ -16,26 +38,152 @@ void Diff::mergeDiff(Diff other) {
 		reservedRouteIds.emplace(id);
 	}
 
-	other.remapCollisions(reservedAnchorIds, reservedRouteIds);
+	// The same item added by both diffs is kept once rather than remapped or refused
+	EarlierAdditions earlier;
+	for (const auto &[id, anchor] : anchorChanges.additions)
+		earlier.anchors.emplace(id, std::pair(anchor, id));
+	earlier.routes.insert(routeChanges.additions.begin(), routeChanges.additions.end());
 
-	anchorChanges.merge(other.anchorChanges);
-	routeChanges.merge(other.routeChanges);
-	stripChanges.merge(other.stripChanges);
+	other.remapCollisions(reservedAnchorIds, reservedRouteIds, &earlier);
+	if (options.deduplicate) {
+		if (const auto duplicates = RouteDeduplicator::deduplicate(other, *this))
+			fmt::print("Dropped {} routes duplicating ones already merged.\n", duplicates);
+	}
+
+	MergeReport localReport;
+	if (!report)
+		report = &localReport;
+	const auto previousConflicts = report->conflicts.size();
+
+	anchorChanges.merge(other.anchorChanges, policy, *report);
+	routeChanges.merge(other.routeChanges, policy, *report);
+	stripChanges.merge(other.stripChanges, policy, *report);
+
+	const auto conflicts = report->conflicts.size() - previousConflicts;
+	if (!resolvesConflicts(policy) && conflicts) {
+		throw std::runtime_error(fmt::format("Refusing to merge diffs with {} conflicting changes.", conflicts));
+	}
 }
-void Diff::remapCollisions(std::set<uint32_t> anchorIds, std::set<uint32_t> routeIds) {
-	// A map between the old and new ids for anchors, only remapped for sub-anchors
-	std::map<uint32_t, uint32_t> anchorIdRemapping;
+Diff Diff::combine(std::vector<Diff> diffs, ReservedIds &anchorIds, ReservedIds &routeIds, ConflictPolicy policy,
+                   MergeReport *report) {
+	// Every diff reserves the ids of its additions for the ones after it,
+	// except for anything an earlier one added identically, which keeps the id it was given there
+	EarlierAdditions earlier;
+	for (auto &diff : diffs)
+		diff.remapCollisions(anchorIds, routeIds, &earlier);
+
+	MergeReport localReport;
+	if (!report)
+		report = &localReport;
+	const auto previousConflicts = report->conflicts.size();
+
+	Diff combined;
+	NetworkItemChanges<uint32_t, Anchor>::combine(diffs, &Diff::anchorChanges, combined.anchorChanges, policy,
+	                                              *report);
+	NetworkItemChanges<std::pair<uint32_t, uint32_t>, Strip>::combine(diffs, &Diff::stripChanges,
+	                                                                  combined.stripChanges, policy, *report);
+	NetworkItemChanges<uint32_t, Route>::combine(diffs, &Diff::routeChanges, combined.routeChanges, policy, *report);
+
+	const auto conflicts = report->conflicts.size() - previousConflicts;
+	if (!resolvesConflicts(policy) && conflicts) {
+		throw std::runtime_error(fmt::format("Refusing to apply diffs with {} conflicting changes.", conflicts));
+	}
+
+	return combined;
+}
+Diff Diff::compose(Diff first, Diff second) {
+	Diff composed;
+	size_t conflicts = 0;
+	conflicts += NetworkItemChanges<uint32_t, Anchor>::compose(first.anchorChanges, second.anchorChanges,
+	                                                           composed.anchorChanges);
+	conflicts += NetworkItemChanges<std::pair<uint32_t, uint32_t>, Strip>::compose(
+	    first.stripChanges, second.stripChanges, composed.stripChanges);
+	conflicts +=
+	    NetworkItemChanges<uint32_t, Route>::compose(first.routeChanges, second.routeChanges, composed.routeChanges);
+	if (conflicts) {
+		throw std::runtime_error(fmt::format("Refusing to compose diffs with {} conflicting changes.", conflicts));
+	}
+
+	return composed;
+}
+void Diff::invert() {
+	anchorChanges.invert();
+	stripChanges.invert();
+	routeChanges.invert();
+}
+size_t Diff::weldHubAnchors(const Diff &onto, float tolerance) {
+	// Only ever looking in the cells right around an anchor keeps this linear in the number of hub anchors
+	AnchorGrid grid(std::max(tolerance, 1.f));
+	for (const auto &anchor : onto.anchorChanges.additions | std::views::values) {
+		if (!anchor.isSubAnchor())
+			grid.insert(anchor);
+	}
+
+	// The hub anchors to replace, and what with
+	std::map<uint32_t, uint32_t> welds;
+	for (const auto &[id, anchor] : anchorChanges.additions) {
+		if (anchor.isSubAnchor())
+			continue;
 
-	// Map reserved ids to themselves, keeping them the same
-	for (const auto &id : anchorIds) {
-		anchorIdRemapping[id] = id;
+		auto same = onto.anchorChanges.additions.find(id);
+		if (same != onto.anchorChanges.additions.end()) {
+			if (std::hypot(same->second.posX() - anchor.posX(), same->second.posY() - anchor.posY()) <= tolerance)
+				welds.emplace(id, id);
+			continue;
+		}
+
+		// The closest hub anchor of the same kind, land hubs are never welded to water hubs
+		for (const auto &match : grid.near(anchor.posX(), anchor.posY(), tolerance)) {
+			if (onto.anchorChanges.additions.at(match.id).isWaterAnchor() == anchor.isWaterAnchor()) {
+				welds.emplace(id, match.id);
+				break;
+			}
+		}
 	}
+	if (welds.empty())
+		return 0;
+
+	for (const auto &id : welds | std::views::keys)
+		anchorChanges.additions.erase(id);
+	for (auto &route : routeChanges.additions | std::views::values)
+		route.remapAnchors(welds);
+	for (auto &route : routeChanges.edits | std::views::values)
+		route.second.remapAnchors(welds);
+
+	// Moving the ends of a strip changes its key, so they have to be reinserted
+	std::map<std::pair<uint32_t, uint32_t>, Strip> newStripAdditions;
+	for (auto &strip : stripChanges.additions | std::views::values) {
+		if (welds.contains(strip.sourceID()))
+			strip.sourceID(welds.at(strip.sourceID()));
+		if (welds.contains(strip.destinationID()))
+			strip.destinationID(welds.at(strip.destinationID()));
+		const auto key = strip.idPair();
+		if (!newStripAdditions.emplace(key, std::move(strip)).second) {
+			fmt::print(std::cerr, "{} is added twice after welding its hub anchors, keeping the first.\n",
+			           newStripAdditions.at(key));
+		}
+	}
+	stripChanges.additions = std::move(newStripAdditions);
+
+	return welds.size();
+}
+void Diff::remapCollisions(ReservedIds &anchorIds, ReservedIds &routeIds, EarlierAdditions *earlier) {
+	// A map between the old and new ids for added anchors, only remapped for sub-anchors
+	// Anything not in here, like the reserved ids, is left as-is
+	std::map<uint32_t, uint32_t> anchorIdRemapping;
 
 	uint32_t landId = 1 | 1 << 28;
 	uint32_t waterId = 1 | 1 << 28 | 1 << 23;
 
 	bool hubCollisions = false;
 	for (const auto &[id, anchor] : anchorChanges.additions) {
+		if (earlier) {
+			const auto same = earlier->anchors.find(id);
+			if (same != earlier->anchors.end() && same->second.first == anchor) {
+				anchorIdRemapping[id] = same->second.second;
+				continue;
+			}
+		}
 		if (!anchorIds.contains(id)) {
 			anchorIdRemapping[id] = id;
 			anchorIds.emplace(id);
@@ -62,16 +210,24 @@ void Diff::remapCollisions(std::set<uint32_t> anchorIds, std::set<uint32_t> rout
 		throw std::runtime_error("Refusing to merge networks with shared Hub Anchors.");
 	}
 
-	// A map between the old and new ids for routes
+	// A map between the old and new ids for added routes
 	std::map<uint32_t, uint32_t> routeIdRemapping;
-	// Map reserved ids to themselves, keeping them the same
-	for (const auto &id : routeIds) {
-		routeIdRemapping[id] = id;
-	}
 
 	std::array<uint32_t, 4> newRouteIds = {1, 1, 1, 1};
 
-	for (const auto &id : routeChanges.additions | std::views::keys) {
+	for (const auto &[id, route] : routeChanges.additions) {
+		if (earlier) {
+			const auto same = earlier->routes.find(id);
+			if (same != earlier->routes.end()) {
+				auto remapped = route;
+				remapped.id(same->second.id());
+				remapped.remapAnchors(anchorIdRemapping);
+				if (remapped == same->second) {
+					routeIdRemapping[id] = same->second.id();
+					continue;
+				}
+			}
+		}
 		if (!routeIds.contains(id)) {
 			routeIdRemapping[id] = id;
 			routeIds.emplace(id);
@@ -89,6 +245,8 @@ void Diff::remapCollisions(std::set<uint32_t> anchorIds, std::set<uint32_t> rout
 
 	std::map<uint32_t, Anchor> newAnchorAdditions;
 	for (auto &[id, anchor] : anchorChanges.additions) {
+		if (earlier)
+			earlier->anchors.try_emplace(id, anchor, anchorIdRemapping.at(id));
 		anchor.id(anchorIdRemapping.at(id));
 		newAnchorAdditions.emplace(anchor.id(), std::move(anchor));
 	}
@@ -98,6 +256,8 @@ void Diff::remapCollisions(std::set<uint32_t> anchorIds, std::set<uint32_t> rout
 	for (auto &[id, route] : routeChanges.additions) {
 		route.id(routeIdRemapping.at(id));
 		route.remapAnchors(anchorIdRemapping);
+		if (earlier)
+			earlier->routes.try_emplace(id, route);
 		newRouteAdditions.emplace(route.id(), std::move(route));
 	}
 	routeChanges.additions = std::move(newRouteAdditions);
@@ -1,8 +1,11 @@
 #pragma once
 
+#include <functional>
 #include <map>
+#include <optional>
 #include <set>
 #include <utility>
+#include <vector>
 
 #include <nlohmann/json.hpp>
 
@@ -11,6 +14,40 @@
 #include "Route.hpp"
 #include "Strip.hpp"
 
+/// Ids that additions can't be remapped to, the ones reserved while remapping plus any taken elsewhere
+class ReservedIds {
+	std::set<uint32_t> _reserved;
+	std::function<bool(uint32_t)> _isTaken;
+
+public:
+	ReservedIds() = default;
+	/// `isTaken` checks for ids already in use, e.g. in a network, without having to copy all of them
+	explicit ReservedIds(std::function<bool(uint32_t)> isTaken)
+	    : _isTaken(std::move(isTaken)) {}
+
+	[[nodiscard]] bool contains(uint32_t id) const { return _reserved.contains(id) || (_isTaken && _isTaken(id)); }
+	void emplace(uint32_t id) { _reserved.emplace(id); }
+};
+
+/// The additions of diffs already remapped, by their id before remapping
+/// An identical addition in a later diff is the same item added again, and is given the same id instead of a new one
+struct EarlierAdditions {
+	/// The anchor as it was added, and the id it was remapped to
+	std::map<uint32_t, std::pair<Anchor, uint32_t>> anchors;
+	/// The route after remapping
+	std::map<uint32_t, Route> routes;
+};
+
+/// How Diff::mergeDiff treats items both diffs change
+struct MergeOptions {
+	ConflictPolicy policy = ConflictPolicy::Fail;
+	/// Weld hub anchors added by both diffs into one if they have the same id, or are within this distance of each
+	/// other, instead of refusing to merge
+	std::optional<float> weldTolerance;
+	/// Drop routes that run through the same anchors as one already merged, pointing their strips at that one instead
+	bool deduplicate = false;
+};
+
 /// A list of changes that can be applied to a Network
 /// Contains complete versions of everything so we can check that the correct version gets replaced
 /// Avoids someone moving an anchor that later get reused for something else getting moved somewhere unexpected
@@ -19,11 +56,39 @@ struct Diff {
 	NetworkItemChanges<std::pair<uint32_t, uint32_t>, Strip> stripChanges;
 	NetworkItemChanges<uint32_t, Route> routeChanges;
 
+	Diff() = default;
+	/// Read the binary form written by writeToFile
+	explicit Diff(SplnetFileReader &fileReader);
+
+	/// Write a compact binary form, much smaller and faster to read than the json
+	void writeToFile(SplnetFileWriter &fileWriter) const;
+
 	/// Merge another diff into this one, will reindex sub-anchors and routes in other
 	/// Will print warnings and throw if multiple hub anchors with the same ID are present
-	void mergeDiff(Diff other);
+	/// Items both diffs change are added to `report` if provided, and anything they leave in different states is
+	/// printed and resolved according to the policy, or thrown if the policy doesn't resolve it
+	void mergeDiff(Diff other, const MergeOptions &options = {}, MergeReport *report = nullptr);
+
+	/// Combine diffs made against the same network in one pass, after remapping their additions with respect to the
+	/// reserved ids and each other. Anything added identically by several diffs is only added once
+	/// Items several diffs change are classified and resolved the same way as in mergeDiff
+	static Diff combine(std::vector<Diff> diffs, ReservedIds &anchorIds, ReservedIds &routeIds,
+	                    ConflictPolicy policy = ConflictPolicy::Fail, MergeReport *report = nullptr);
+
+	/// A diff with the effect of applying `first` and then `second`, without needing the network they apply to
+	/// Will print and throw if `second` adds anything `first` leaves in place
+	static Diff compose(Diff first, Diff second);
+	/// Turn the diff into one that undoes it
+	void invert();
+
+	/// Replace the hub anchors this diff adds with the ones `onto` adds with the same id and within `tolerance`,
+	/// or with a different id and within `tolerance`, rewriting the routes and strips using them
+	/// Hub anchors with the same id further apart are left for remapCollisions to refuse. Returns the number welded
+	size_t weldHubAnchors(const Diff &onto, float tolerance);
 
 	/// Remap subanchors and routes with respect to the provided reserved ids
-	void remapCollisions(std::set<uint32_t> anchorIds, std::set<uint32_t> routeIds);
+	/// The ids of the additions get reserved as well, for remapping later diffs
+	/// Additions identical to one in `earlier` take the id it was given, the rest are added to it
+	void remapCollisions(ReservedIds &anchorIds, ReservedIds &routeIds, EarlierAdditions *earlier = nullptr);
 };
 NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(Diff, anchorChanges, stripChanges, routeChanges);
@@ -0,0 +1,99 @@
+#include "MappedFile.hpp"
+
+#include <system_error>
+#include <utility>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include <fmt/format.h>
+
+#ifdef _WIN32
+MappedFile::MappedFile(const std::filesystem::path &path) {
+	HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+	                          FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		throw std::system_error(static_cast<int>(GetLastError()), std::system_category(),
+		                        fmt::format("Could not open \"{}\"", path.string()));
+
+	LARGE_INTEGER size;
+	GetFileSizeEx(file, &size);
+	_size = static_cast<size_t>(size.QuadPart);
+
+	// Mapping an empty file is an error on Windows, leave it as an empty span instead
+	if (_size != 0) {
+		_mappingHandle = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (_mappingHandle)
+			_data = static_cast<const char *>(MapViewOfFile(_mappingHandle, FILE_MAP_READ, 0, 0, 0));
+	}
+	CloseHandle(file);
+
+	if (_size != 0 && !_data) {
+		unmap();
+		throw std::system_error(static_cast<int>(GetLastError()), std::system_category(),
+		                        fmt::format("Could not map \"{}\"", path.string()));
+	}
+}
+void MappedFile::unmap() {
+	if (_data)
+		UnmapViewOfFile(_data);
+	if (_mappingHandle)
+		CloseHandle(_mappingHandle);
+	_data = nullptr;
+	_mappingHandle = nullptr;
+	_size = 0;
+}
+#else
+MappedFile::MappedFile(const std::filesystem::path &path) {
+	const int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		throw std::system_error(errno, std::generic_category(), fmt::format("Could not open \"{}\"", path.string()));
+
+	_size = std::filesystem::file_size(path);
+
+	// mmap refuses zero-length mappings, leave it as an empty span instead
+	if (_size != 0) {
+		void *mapping = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (mapping == MAP_FAILED) {
+			const int error = errno;
+			close(fd);
+			throw std::system_error(error, std::generic_category(), fmt::format("Could not map \"{}\"", path.string()));
+		}
+		_data = static_cast<const char *>(mapping);
+	}
+	close(fd);
+}
+void MappedFile::unmap() {
+	if (_data)
+		munmap(const_cast<char *>(_data), _size);
+	_data = nullptr;
+	_size = 0;
+}
+#endif
+
+MappedFile::~MappedFile() { unmap(); }
+
+MappedFile::MappedFile(MappedFile &&other) noexcept
+    : _data(std::exchange(other._data, nullptr))
+    , _size(std::exchange(other._size, 0))
+#ifdef _WIN32
+    , _mappingHandle(std::exchange(other._mappingHandle, nullptr))
+#endif
+{
+}
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+	if (this != &other) {
+		unmap();
+		_data = std::exchange(other._data, nullptr);
+		_size = std::exchange(other._size, 0);
+#ifdef _WIN32
+		_mappingHandle = std::exchange(other._mappingHandle, nullptr);
+#endif
+	}
+	return *this;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <filesystem>
+#include <span>
+
+/// A read-only memory mapping of an entire file
+/// Lets the OS page in only the parts of the file that are actually touched
+class MappedFile {
+	const char *_data = nullptr;
+	size_t _size = 0;
+#ifdef _WIN32
+	void *_mappingHandle = nullptr;
+#endif
+
+	void unmap();
+
+public:
+	MappedFile() = default;
+	explicit MappedFile(const std::filesystem::path &path);
+	~MappedFile();
+
+	MappedFile(const MappedFile &) = delete;
+	MappedFile &operator=(const MappedFile &) = delete;
+	MappedFile(MappedFile &&other) noexcept;
+	MappedFile &operator=(MappedFile &&other) noexcept;
+
+	[[nodiscard]] std::span<const char> data() const { return {_data, _size}; }
+	[[nodiscard]] size_t size() const { return _size; }
+};
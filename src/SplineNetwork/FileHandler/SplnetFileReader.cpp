@@ -3,10 +3,12 @@
 #include <utility>
 
 SplnetFileReader::SplnetFileReader(std::filesystem::path path)
-    : _path(std::move(path)) {
-	_file.exceptions(std::ios::badbit | std::ios::failbit);
-	_file.open(_path, std::ios::in | std::ios::binary);
-}
+    : _mapping(path)
+    , _data(_mapping.data())
+    , _path(std::move(path)) {}
+SplnetFileReader::SplnetFileReader(std::span<const char> data, size_t offset)
+    : _data(data)
+    , _readPos(offset) {}
 
 void SplnetFileReader::expectSectionHeader(uint16_t id) {
 	expect(id);
@@ -1,23 +1,34 @@
 #pragma once
 
+#include <cstring>
 #include <filesystem>
-#include <fstream>
+#include <span>
 
 #include <fmt/format.h>
 
+#include "MappedFile.hpp"
+
 class SplnetFileReader {
-	std::ifstream _file;
-	std::streamoff _readPos = 0;
+	// Empty when reading from a borrowed buffer
+	MappedFile _mapping;
+	std::span<const char> _data;
+	size_t _readPos = 0;
 	const std::filesystem::path _path;
 
 public:
 	explicit SplnetFileReader(std::filesystem::path path);
+	/// Read from an existing buffer, starting at `offset`. The buffer must outlive the reader
+	explicit SplnetFileReader(std::span<const char> data, size_t offset = 0);
 
 	/// Read sizeof(T) bytes from the file, and interpret them as a bitwise representation of T
 	/// Warning: Do not use with anything but primitives or maybe POD structs of primitives
 	template <typename T> [[nodiscard]] T read() {
+		if (_readPos + sizeof(T) > _data.size()) {
+			throw std::runtime_error(fmt::format("Unexpected end of file at position {:#x}", _readPos));
+		}
+
 		T value;
-		_file.read(reinterpret_cast<char *>(&value), sizeof(T));
+		std::memcpy(&value, _data.data() + _readPos, sizeof(T));
 
 		_readPos += sizeof(T);
 
@@ -33,13 +44,24 @@ public:
 	}
 	/// Call read() with type T and then back up again, ensuring the same value gets read if called again
 	template <typename T> T peek() {
-		const auto startPos = _file.tellg();
 		T ret = read<T>();
 		_readPos -= sizeof(T);
-		_file.seekg(startPos);
 		return ret;
 	}
 
+	/// Read `count` raw bytes, pointing into the underlying buffer
+	[[nodiscard]] std::span<const char> readBytes(size_t count) {
+		if (_readPos + count > _data.size()) {
+			throw std::runtime_error(fmt::format("Unexpected end of file at position {:#x}", _readPos));
+		}
+
+		const auto bytes = _data.subspan(_readPos, count);
+		_readPos += count;
+		return bytes;
+	}
+
+	[[nodiscard]] size_t position() const { return _readPos; }
+
 	void expectSectionHeader(uint16_t id);
 	void expectElementHeader();
 	void expectElementFooter(bool isFinal = false);
@@ -1,9 +1,12 @@
 #include "SplnetFileWriter.hpp"
 
-SplnetFileWriter::SplnetFileWriter(std::filesystem::path path)
-    : _path(std::move(path)) {
-	_file.exceptions(std::ios::badbit | std::ios::failbit);
-	_file.open(_path, std::ios::out | std::ios::binary | std::ios::trunc);
+#include <fstream>
+
+void SplnetFileWriter::save(const std::filesystem::path &path) const {
+	std::ofstream file;
+	file.exceptions(std::ios::badbit | std::ios::failbit);
+	file.open(path, std::ios::out | std::ios::binary | std::ios::trunc);
+	file.write(_buffer.data(), static_cast<std::streamsize>(_buffer.size()));
 }
 
 void SplnetFileWriter::writeSectionHeader(uint16_t id) {
@@ -1,21 +1,29 @@
 #pragma once
 
 #include <filesystem>
-#include <fstream>
+#include <span>
+#include <vector>
 
+/// Builds the file in memory, which is then written all at once with save()
 class SplnetFileWriter {
-	std::ofstream _file;
-	std::streamoff _writePos = 0;
-	const std::filesystem::path _path;
+	std::vector<char> _buffer;
 
 public:
-	explicit SplnetFileWriter(std::filesystem::path path);
+	SplnetFileWriter() = default;
 
 	template <typename T> void write(T value) {
-		_file.write(reinterpret_cast<char *>(&value), sizeof(T));
-		_writePos += sizeof(T);
+		const auto *bytes = reinterpret_cast<const char *>(&value);
+		_buffer.insert(_buffer.end(), bytes, bytes + sizeof(T));
 	}
 
+	void writeBytes(std::span<const char> bytes) { _buffer.insert(_buffer.end(), bytes.begin(), bytes.end()); }
+
+	[[nodiscard]] size_t position() const { return _buffer.size(); }
+	[[nodiscard]] const std::vector<char> &buffer() const { return _buffer; }
+	[[nodiscard]] std::vector<char> takeBuffer() { return std::move(_buffer); }
+
+	void save(const std::filesystem::path &path) const;
+
 	void writeSectionHeader(uint16_t id);
 	void writeElementHeader();
 	void writeElementFooter(bool isFinal = false);
@@ -0,0 +1,134 @@
+#include "SplnetIndex.hpp"
+
+#include <algorithm>
+#include <ranges>
+
+#include "SplnetFileReader.hpp"
+#include "SplnetFileWriter.hpp"
+
+namespace {
+	constexpr uint32_t indexMagic = 0x58444953; // "SIDX"
+	constexpr uint32_t indexVersion = 1;
+
+	int64_t modificationTime(const std::filesystem::path &path) {
+		return std::filesystem::last_write_time(path).time_since_epoch().count();
+	}
+
+	void writeKey(SplnetFileWriter &fileWriter, uint32_t key) { fileWriter.write(key); }
+	void writeKey(SplnetFileWriter &fileWriter, std::pair<uint32_t, uint32_t> key) {
+		fileWriter.write(key.first);
+		fileWriter.write(key.second);
+	}
+	void readKey(SplnetFileReader &fileReader, uint32_t &key) { key = fileReader.read<uint32_t>(); }
+	void readKey(SplnetFileReader &fileReader, std::pair<uint32_t, uint32_t> &key) {
+		key.first = fileReader.read<uint32_t>();
+		key.second = fileReader.read<uint32_t>();
+	}
+
+	template <typename S> void writeSection(SplnetFileWriter &fileWriter, const S &section) {
+		fileWriter.write(static_cast<uint32_t>(section.entries.size()));
+		for (const auto &[key, offset] : section.entries) {
+			writeKey(fileWriter, key);
+			fileWriter.write(offset);
+		}
+	}
+	template <typename S> void readSection(SplnetFileReader &fileReader, S &section) {
+		const auto count = fileReader.read<uint32_t>();
+		section.entries.resize(count);
+		for (auto &[key, offset] : section.entries) {
+			readKey(fileReader, key);
+			offset = fileReader.read<uint32_t>();
+		}
+		section.sort();
+	}
+} // namespace
+
+template <typename K> void SplnetIndex::Section<K>::sort() {
+	std::ranges::sort(entries);
+	finalOffset = 0;
+	for (const auto &offset : entries | std::views::values)
+		finalOffset = std::max(finalOffset, offset);
+}
+
+SplnetIndex::SplnetIndex(const std::filesystem::path &indexPath) {
+	SplnetFileReader fileReader(indexPath);
+
+	fileReader.expect(indexMagic);
+	fileReader.expect(indexVersion);
+	_fileSize = fileReader.read<uint64_t>();
+	_modificationTime = fileReader.read<int64_t>();
+
+	readSection(fileReader, _anchors);
+	readSection(fileReader, _routes);
+	readSection(fileReader, _strips);
+}
+void SplnetIndex::writeToFile(const std::filesystem::path &indexPath) const {
+	SplnetFileWriter fileWriter;
+
+	fileWriter.write(indexMagic);
+	fileWriter.write(indexVersion);
+	fileWriter.write(_fileSize);
+	fileWriter.write(_modificationTime);
+
+	writeSection(fileWriter, _anchors);
+	writeSection(fileWriter, _routes);
+	writeSection(fileWriter, _strips);
+
+	fileWriter.save(indexPath);
+}
+
+std::filesystem::path SplnetIndex::sidecarPath(const std::filesystem::path &networkPath) {
+	return std::filesystem::path(networkPath).replace_extension(".splidx");
+}
+
+void SplnetIndex::finalize(const std::filesystem::path &networkPath) {
+	_anchors.sort();
+	_routes.sort();
+	_strips.sort();
+
+	_fileSize = std::filesystem::file_size(networkPath);
+	_modificationTime = modificationTime(networkPath);
+}
+bool SplnetIndex::isStale(const std::filesystem::path &networkPath) const {
+	return std::filesystem::file_size(networkPath) != _fileSize || modificationTime(networkPath) != _modificationTime;
+}
+
+std::optional<SplnetIndex::Record> SplnetIndex::findAnchor(uint32_t id) const {
+	auto it = std::ranges::lower_bound(_anchors.entries, id, {}, &std::pair<uint32_t, uint32_t>::first);
+	if (it == _anchors.entries.end() || it->first != id)
+		return std::nullopt;
+	return _anchors.record(it->second);
+}
+std::optional<SplnetIndex::Record> SplnetIndex::findRoute(uint32_t id) const {
+	auto it = std::ranges::lower_bound(_routes.entries, id, {}, &std::pair<uint32_t, uint32_t>::first);
+	if (it == _routes.entries.end() || it->first != id)
+		return std::nullopt;
+	return _routes.record(it->second);
+}
+std::vector<SplnetIndex::Record> SplnetIndex::findStrips(uint32_t sourceID, uint32_t destinationID) const {
+	// Strips are keyed on the raw IDs, where the lowest 6 bits of the source is the type,
+	// so every type of strip between the two anchors is in one contiguous range
+	const std::pair<uint32_t, uint32_t> first = {destinationID << 3, sourceID << 6};
+	const std::pair<uint32_t, uint32_t> last = {destinationID << 3, (sourceID << 6) | ((1 << 6) - 1)};
+
+	std::vector<Record> records;
+	using Entry = std::pair<std::pair<uint32_t, uint32_t>, uint32_t>;
+	for (auto it = std::ranges::lower_bound(_strips.entries, first, {}, &Entry::first);
+	     it != _strips.entries.end() && it->first <= last; ++it) {
+		records.emplace_back(_strips.record(it->second));
+	}
+	return records;
+}
+std::optional<SplnetIndex::Location> SplnetIndex::locate(uint64_t offset) const {
+	std::optional<Location> closest;
+	const auto search = [&](const auto &section, RecordType type) {
+		for (const auto recordOffset : section.entries | std::views::values) {
+			if (recordOffset <= offset && (!closest || recordOffset > closest->record.offset))
+				closest = Location{type, section.record(recordOffset)};
+		}
+	};
+	search(_anchors, RecordType::Anchor);
+	search(_routes, RecordType::Route);
+	search(_strips, RecordType::Strip);
+	return closest;
+}
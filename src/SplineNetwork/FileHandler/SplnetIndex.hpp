@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <utility>
+#include <vector>
+
+/// The sorted IDs and byte offsets of every record in a .splnet file
+/// Stored next to the network as a `.splidx` sidecar, allowing single records to be decoded without parsing everything
+class SplnetIndex {
+public:
+	/// Where a record starts in the network file,
+	/// and whether it is the last one in its section, since that changes the footer
+	struct Record {
+		uint32_t offset;
+		bool isFinal;
+	};
+	enum class RecordType { Anchor, Route, Strip };
+	struct Location {
+		RecordType type;
+		Record record;
+	};
+
+private:
+	template <typename K> struct Section {
+		std::vector<std::pair<K, uint32_t>> entries;
+		uint32_t finalOffset = 0;
+
+		void sort();
+		[[nodiscard]] Record record(uint32_t offset) const { return {offset, offset == finalOffset}; }
+	};
+
+	// Used to detect if the network has been changed since the index was built
+	uint64_t _fileSize = 0;
+	int64_t _modificationTime = 0;
+
+	Section<uint32_t> _anchors;
+	Section<uint32_t> _routes;
+	Section<std::pair<uint32_t, uint32_t>> _strips;
+
+public:
+	SplnetIndex() = default;
+	/// Read an index file
+	explicit SplnetIndex(const std::filesystem::path &indexPath);
+
+	void writeToFile(const std::filesystem::path &indexPath) const;
+
+	/// `spline_network.splnet` -> `spline_network.splidx`
+	static std::filesystem::path sidecarPath(const std::filesystem::path &networkPath);
+
+	void addAnchor(uint32_t id, uint32_t offset) { _anchors.entries.emplace_back(id, offset); }
+	void addRoute(uint32_t id, uint32_t offset) { _routes.entries.emplace_back(id, offset); }
+	void addStrip(std::pair<uint32_t, uint32_t> idPair, uint32_t offset) {
+		_strips.entries.emplace_back(idPair, offset);
+	}
+
+	/// Sort the entries and record the size and modification time of the finished network file
+	void finalize(const std::filesystem::path &networkPath);
+	/// Whether the network file has been changed since this index was built
+	[[nodiscard]] bool isStale(const std::filesystem::path &networkPath) const;
+
+	[[nodiscard]] std::optional<Record> findAnchor(uint32_t id) const;
+	[[nodiscard]] std::optional<Record> findRoute(uint32_t id) const;
+	/// Find all strips between the two hub anchors (by their full IDs, the same as findAnchor), one per strip type
+	[[nodiscard]] std::vector<Record> findStrips(uint32_t sourceID, uint32_t destinationID) const;
+	/// The last record starting at or before `offset`, nullopt if `offset` is before the first record
+	/// The offset may still be past the end of that record, in the header of the following section
+	[[nodiscard]] std::optional<Location> locate(uint64_t offset) const;
+};
@@ -0,0 +1,171 @@
+#include "NetworkArchive.hpp"
+
+#include <algorithm>
+#include <charconv>
+
+#include <fmt/format.h>
+#include <zlib.h>
+
+#include "FileHandler/MappedFile.hpp"
+#include "FileHandler/SplnetFileReader.hpp"
+#include "FileHandler/SplnetFileWriter.hpp"
+
+namespace {
+	constexpr uint32_t archiveMagic = 0x43524153; // "SARC"
+	constexpr uint32_t archiveVersion = 1;
+
+	std::vector<char> compress(std::span<const char> data) {
+		auto compressedSize = compressBound(static_cast<uLong>(data.size()));
+		std::vector<char> compressed(compressedSize);
+		if (compress2(reinterpret_cast<Bytef *>(compressed.data()), &compressedSize,
+		              reinterpret_cast<const Bytef *>(data.data()), static_cast<uLong>(data.size()),
+		              Z_BEST_COMPRESSION) != Z_OK) {
+			throw std::runtime_error("Failed to compress archive version");
+		}
+		compressed.resize(compressedSize);
+		return compressed;
+	}
+	std::vector<char> decompress(const NetworkArchive::Version &version) {
+		std::vector<char> data(version.uncompressedSize);
+		auto size = static_cast<uLongf>(data.size());
+		if (uncompress(reinterpret_cast<Bytef *>(data.data()), &size,
+		               reinterpret_cast<const Bytef *>(version.data.data()),
+		               static_cast<uLong>(version.data.size())) != Z_OK ||
+		    size != data.size()) {
+			throw std::runtime_error(fmt::format("Archive version \"{}\" is corrupt", version.name));
+		}
+		return data;
+	}
+
+	template <typename K, typename T>
+	NetworkArchive::ChangeCounts countChanges(const NetworkItemChanges<K, T> &changes) {
+		return {static_cast<uint32_t>(changes.additions.size()), static_cast<uint32_t>(changes.deletions.size()),
+		        static_cast<uint32_t>(changes.edits.size())};
+	}
+} // namespace
+
+NetworkArchive::NetworkArchive(const std::filesystem::path &path) {
+	SplnetFileReader fileReader(path);
+
+	fileReader.expect(archiveMagic);
+	fileReader.expect(archiveVersion);
+	_snapshotInterval = fileReader.read<uint32_t>();
+	_versions.resize(fileReader.read<uint32_t>());
+
+	for (auto &version : _versions) {
+		version.isSnapshot = fileReader.read<uint8_t>();
+		const auto nameSpan = fileReader.readBytes(fileReader.read<uint32_t>());
+		version.name.assign(nameSpan.begin(), nameSpan.end());
+		for (auto &[additions, deletions, edits] : version.changes) {
+			additions = fileReader.read<uint32_t>();
+			deletions = fileReader.read<uint32_t>();
+			edits = fileReader.read<uint32_t>();
+		}
+		version.uncompressedSize = fileReader.read<uint64_t>();
+		const auto data = fileReader.readBytes(fileReader.read<uint64_t>());
+		version.data.assign(data.begin(), data.end());
+	}
+}
+void NetworkArchive::writeToFile(const std::filesystem::path &path) const {
+	SplnetFileWriter fileWriter;
+
+	fileWriter.write(archiveMagic);
+	fileWriter.write(archiveVersion);
+	fileWriter.write(_snapshotInterval);
+	fileWriter.write(static_cast<uint32_t>(_versions.size()));
+
+	for (const auto &version : _versions) {
+		fileWriter.write<uint8_t>(version.isSnapshot);
+		fileWriter.write(static_cast<uint32_t>(version.name.size()));
+		fileWriter.writeBytes(version.name);
+		for (const auto &[additions, deletions, edits] : version.changes) {
+			fileWriter.write(additions);
+			fileWriter.write(deletions);
+			fileWriter.write(edits);
+		}
+		fileWriter.write(version.uncompressedSize);
+		fileWriter.write(static_cast<uint64_t>(version.data.size()));
+		fileWriter.writeBytes(version.data);
+	}
+
+	fileWriter.save(path);
+}
+
+void NetworkArchive::addVersion(std::string name, const std::filesystem::path &networkPath) {
+	fmt::print("Reading \"{}\"\n", networkPath.string());
+
+	const MappedFile file(networkPath);
+	const SplineNetwork network(file.data());
+
+	Version version;
+	version.name = std::move(name);
+	version.isSnapshot = _versions.empty() || _versions.size() % _snapshotInterval == 0;
+
+	if (!_versions.empty()) {
+		SplineNetwork previous = checkoutNetwork(_versions.size() - 1);
+		const auto diff = previous.calculateDiff(network);
+		version.changes = {countChanges(diff.anchorChanges), countChanges(diff.stripChanges),
+		                   countChanges(diff.routeChanges)};
+
+		if (!version.isSnapshot) {
+			// A diff only reproduces the file exactly if it was written in the same order as we write it,
+			// anything else has to be stored as-is
+			previous.applyDiff(diff);
+			version.isSnapshot = !std::ranges::equal(previous.toBytes(), file.data());
+		}
+
+		if (!version.isSnapshot) {
+			SplnetFileWriter diffWriter;
+			diff.writeToFile(diffWriter);
+			// Deletions are stored in full, so a rewrite can end up larger than the file itself
+			version.isSnapshot = diffWriter.position() >= file.size();
+			if (!version.isSnapshot) {
+				version.uncompressedSize = diffWriter.position();
+				version.data = compress(diffWriter.buffer());
+			}
+		}
+	}
+
+	if (version.isSnapshot) {
+		version.uncompressedSize = file.size();
+		version.data = compress(file.data());
+	}
+
+	_versions.push_back(std::move(version));
+}
+
+SplineNetwork NetworkArchive::checkoutNetwork(size_t index) const {
+	size_t snapshot = index;
+	while (!_versions.at(snapshot).isSnapshot)
+		--snapshot;
+
+	const auto snapshotData = decompress(_versions[snapshot]);
+	SplineNetwork network{std::span<const char>(snapshotData)};
+	for (size_t i = snapshot + 1; i <= index; ++i) {
+		const auto data = decompress(_versions[i]);
+		SplnetFileReader fileReader(data);
+		network.applyDiff(Diff(fileReader));
+	}
+	return network;
+}
+std::vector<char> NetworkArchive::checkout(size_t index) const {
+	// Snapshots are the original file, no need to parse them
+	if (_versions.at(index).isSnapshot)
+		return decompress(_versions[index]);
+
+	return checkoutNetwork(index).toBytes();
+}
+
+std::optional<size_t> NetworkArchive::findVersion(std::string_view nameOrIndex) const {
+	// Prefer the latest version if a name has been reused
+	for (size_t i = _versions.size(); i-- > 0;) {
+		if (_versions[i].name == nameOrIndex)
+			return i;
+	}
+
+	size_t index;
+	const auto [end, error] = std::from_chars(nameOrIndex.data(), nameOrIndex.data() + nameOrIndex.size(), index);
+	if (error != std::errc() || end != nameOrIndex.data() + nameOrIndex.size() || index >= _versions.size())
+		return std::nullopt;
+	return index;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "SplineNetwork.hpp"
+
+/// A sequence of versions of one network, stored as periodic full snapshots with chains of diffs between them
+/// Everything is zlib compressed, snapshots are the original file and diffs are in the binary Diff format
+class NetworkArchive {
+public:
+	struct ChangeCounts {
+		uint32_t additions = 0;
+		uint32_t deletions = 0;
+		uint32_t edits = 0;
+	};
+	struct Version {
+		std::string name;
+		bool isSnapshot = false;
+		/// Compared to the previous version, for anchors, strips, and routes, so log doesn't need to decompress
+		std::array<ChangeCounts, 3> changes;
+		uint64_t uncompressedSize = 0;
+		std::vector<char> data;
+	};
+
+private:
+	uint32_t _snapshotInterval = 16;
+	std::vector<Version> _versions;
+
+	[[nodiscard]] SplineNetwork checkoutNetwork(size_t index) const;
+
+public:
+	NetworkArchive() = default;
+	explicit NetworkArchive(const std::filesystem::path &path);
+
+	void writeToFile(const std::filesystem::path &path) const;
+
+	[[nodiscard]] auto snapshotInterval() const { return _snapshotInterval; }
+	/// Only applies to versions added after this is set
+	void snapshotInterval(uint32_t set) { _snapshotInterval = set; }
+
+	/// Append a network file as the newest version,
+	/// stored as a diff against the previous version unless a snapshot is due
+	void addVersion(std::string name, const std::filesystem::path &networkPath);
+
+	/// The file contents of version `index`, replaying the diffs from the closest earlier snapshot
+	[[nodiscard]] std::vector<char> checkout(size_t index) const;
+
+	/// Look up a version by name, or by index if no name matches
+	[[nodiscard]] std::optional<size_t> findVersion(std::string_view nameOrIndex) const;
+	[[nodiscard]] const auto &versions() const { return _versions; }
+};
@@ -0,0 +1,179 @@
+#include "NetworkGraph.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <queue>
+#include <ranges>
+#include <tuple>
+
+namespace {
+	float routeLength(const Route &route, const SplineNetwork::AnchorMap &anchors) {
+		float length = 0;
+		const Anchor *previous = nullptr;
+		for (const auto id : route.anchors()) {
+			auto it = anchors.find(id);
+			if (it == anchors.end())
+				continue;
+			if (previous)
+				length += std::hypot(it->second.posX() - previous->posX(), it->second.posY() - previous->posY());
+			previous = &it->second;
+		}
+		return length;
+	}
+} // namespace
+
+NetworkGraph::NetworkGraph(const SplineNetwork &network, std::span<const Strip::Type> types) {
+	for (const auto &[id, anchor] : network.anchors()) {
+		if (anchor.isSubAnchor())
+			continue;
+		_nodeAnchors.push_back(id);
+		_nodeX.push_back(anchor.posX());
+		_nodeY.push_back(anchor.posY());
+	}
+
+	struct Edge {
+		uint32_t from;
+		uint32_t to;
+		float length;
+		Strip::Type type;
+	};
+	std::vector<Edge> edges;
+	for (const auto &strip : network.strips() | std::views::values) {
+		if (!types.empty() && std::ranges::find(types, strip.type()) == types.end())
+			continue;
+
+		const auto from = node(strip.sourceID());
+		const auto to = node(strip.destinationID());
+		if (!from || !to)
+			continue;
+
+		float length = std::numeric_limits<float>::infinity();
+		for (const auto routeID : strip.routeIDs()) {
+			auto it = network.routes().find(static_cast<uint32_t>(routeID));
+			if (it != network.routes().end())
+				length = std::min(length, routeLength(it->second, network.anchors()));
+		}
+		// Keep the heuristic admissible, no path can be shorter than a straight line
+		length = std::max(length == std::numeric_limits<float>::infinity() ? 0 : length, distance(*from, *to));
+
+		edges.push_back({*from, *to, length, strip.type()});
+		edges.push_back({*to, *from, length, strip.type()});
+	}
+
+	// Counting sort the edges by their source node
+	_edgeOffsets.assign(_nodeAnchors.size() + 1, 0);
+	for (const auto &edge : edges)
+		_edgeOffsets[edge.from + 1]++;
+	for (size_t i = 1; i < _edgeOffsets.size(); ++i)
+		_edgeOffsets[i] += _edgeOffsets[i - 1];
+
+	_edgeTargets.resize(edges.size());
+	_edgeLengths.resize(edges.size());
+	_edgeTypes.resize(edges.size());
+	auto insertPosition = _edgeOffsets;
+	for (const auto &edge : edges) {
+		const auto position = insertPosition[edge.from]++;
+		_edgeTargets[position] = edge.to;
+		_edgeLengths[position] = edge.length;
+		_edgeTypes[position] = edge.type;
+	}
+}
+
+std::optional<uint32_t> NetworkGraph::node(uint32_t anchorID) const {
+	auto it = std::ranges::lower_bound(_nodeAnchors, anchorID);
+	if (it == _nodeAnchors.end() || *it != anchorID)
+		return std::nullopt;
+	return static_cast<uint32_t>(it - _nodeAnchors.begin());
+}
+float NetworkGraph::distance(uint32_t from, uint32_t to) const {
+	return std::hypot(_nodeX[to] - _nodeX[from], _nodeY[to] - _nodeY[from]);
+}
+
+std::optional<NetworkGraph::Path> NetworkGraph::shortestPath(uint32_t fromAnchor, uint32_t toAnchor) const {
+	const auto start = node(fromAnchor);
+	const auto goal = node(toAnchor);
+	if (!start || !goal)
+		return std::nullopt;
+
+	constexpr auto unreached = std::numeric_limits<uint32_t>::max();
+	std::vector<float> costs(nodeCount(), std::numeric_limits<float>::infinity());
+	// The edge used to reach every node, for reconstructing the path
+	std::vector<uint32_t> cameFrom(nodeCount(), unreached);
+
+	// (estimated total cost, cost so far, node), smallest estimate first
+	using Entry = std::tuple<float, float, uint32_t>;
+	std::priority_queue<Entry, std::vector<Entry>, std::greater<>> open;
+	costs[*start] = 0;
+	open.emplace(distance(*start, *goal), 0.0f, *start);
+
+	while (!open.empty()) {
+		const auto [estimate, cost, current] = open.top();
+		open.pop();
+		if (current == *goal)
+			break;
+		// Stale entry, the node has since been reached more cheaply
+		if (cost > costs[current])
+			continue;
+
+		for (auto edge = _edgeOffsets[current]; edge < _edgeOffsets[current + 1]; ++edge) {
+			const auto next = _edgeTargets[edge];
+			const auto nextCost = cost + _edgeLengths[edge];
+			if (nextCost >= costs[next])
+				continue;
+
+			costs[next] = nextCost;
+			cameFrom[next] = edge;
+			open.emplace(nextCost + distance(next, *goal), nextCost, next);
+		}
+	}
+
+	if (costs[*goal] == std::numeric_limits<float>::infinity())
+		return std::nullopt;
+
+	// Walk back from the goal, finding the source of every edge by its position in the offset list
+	Path path;
+	path.length = costs[*goal];
+	for (auto current = *goal; current != *start;) {
+		const auto edge = cameFrom[current];
+		const auto previous =
+		    static_cast<uint32_t>(std::ranges::upper_bound(_edgeOffsets, edge) - _edgeOffsets.begin() - 1);
+		path.steps.push_back({_nodeAnchors[previous], _nodeAnchors[current], _edgeTypes[edge], _edgeLengths[edge]});
+		current = previous;
+	}
+	std::ranges::reverse(path.steps);
+
+	return path;
+}
+
+std::vector<std::vector<uint32_t>> NetworkGraph::components() const {
+	std::vector<std::vector<uint32_t>> components;
+	std::vector<bool> visited(nodeCount(), false);
+	std::vector<uint32_t> stack;
+
+	for (uint32_t root = 0; root < nodeCount(); ++root) {
+		if (visited[root])
+			continue;
+
+		auto &component = components.emplace_back();
+		visited[root] = true;
+		stack.push_back(root);
+		while (!stack.empty()) {
+			const auto current = stack.back();
+			stack.pop_back();
+			component.push_back(_nodeAnchors[current]);
+
+			for (auto edge = _edgeOffsets[current]; edge < _edgeOffsets[current + 1]; ++edge) {
+				const auto next = _edgeTargets[edge];
+				if (!visited[next]) {
+					visited[next] = true;
+					stack.push_back(next);
+				}
+			}
+		}
+		std::ranges::sort(component);
+	}
+
+	std::ranges::stable_sort(components, std::greater<>(), &std::vector<uint32_t>::size);
+	return components;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "SplineNetwork.hpp"
+
+/// A read-only graph of a network, with hub anchors as nodes and strips as undirected edges
+/// Stored in compressed sparse row form, the edges of node `n` are [_edgeOffsets[n], _edgeOffsets[n + 1])
+class NetworkGraph {
+public:
+	struct Step {
+		uint32_t from;
+		uint32_t to;
+		Strip::Type type;
+		float length;
+	};
+	struct Path {
+		std::vector<Step> steps;
+		float length = 0;
+	};
+
+private:
+	// Sorted, so nodes can be looked up by binary search
+	std::vector<uint32_t> _nodeAnchors;
+	std::vector<float> _nodeX;
+	std::vector<float> _nodeY;
+
+	std::vector<uint32_t> _edgeOffsets;
+	std::vector<uint32_t> _edgeTargets;
+	std::vector<float> _edgeLengths;
+	std::vector<Strip::Type> _edgeTypes;
+
+	[[nodiscard]] std::optional<uint32_t> node(uint32_t anchorID) const;
+	[[nodiscard]] float distance(uint32_t from, uint32_t to) const;
+
+public:
+	/// Only include strips of the given types, or all of them if `types` is empty
+	/// Edges are weighted by the length of the shortest route in the strip
+	explicit NetworkGraph(const SplineNetwork &network, std::span<const Strip::Type> types = {});
+
+	[[nodiscard]] size_t nodeCount() const { return _nodeAnchors.size(); }
+	/// Every edge is stored once in each direction
+	[[nodiscard]] size_t edgeCount() const { return _edgeTargets.size() / 2; }
+
+	/// A* search between two hub anchors, nullopt if either is missing or there is no connection
+	[[nodiscard]] std::optional<Path> shortestPath(uint32_t fromAnchor, uint32_t toAnchor) const;
+	/// The anchor IDs in every connected component, largest first
+	[[nodiscard]] std::vector<std::vector<uint32_t>> components() const;
+};
@@ -1,10 +1,59 @@
 #pragma once
 
+#include <initializer_list>
+#include <iostream>
 #include <map>
+#include <optional>
+#include <ranges>
+#include <string>
+#include <string_view>
 #include <utility>
+#include <vector>
 
+#include <fmt/ostream.h>
 #include <nlohmann/json.hpp>
 
+#include "FileHandler/SplnetFileReader.hpp"
+#include "FileHandler/SplnetFileWriter.hpp"
+
+/// What merging does with items two sets of changes leave in different states
+enum class ConflictPolicy {
+	Fail,
+	/// Items deleted by one and edited by the other are deleted, other conflicts still fail
+	PreferDeletions,
+	PreferFirst,
+	PreferLast,
+};
+/// Whether every conflict is resolved under `policy`, rather than some having to be refused
+constexpr bool resolvesConflicts(ConflictPolicy policy) {
+	return policy == ConflictPolicy::PreferFirst || policy == ConflictPolicy::PreferLast;
+}
+
+/// An item two sets of changes leave in different states
+struct MergeConflict {
+	std::string item;
+	/// "added", "deleted", or "edited"
+	std::string firstAction;
+	std::string secondAction;
+	/// Null if deleted
+	nlohmann::json firstVersion;
+	nlohmann::json secondVersion;
+};
+NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(MergeConflict, item, firstAction, secondAction, firstVersion, secondVersion);
+
+/// The items changed by both sides of a merge
+struct MergeReport {
+	/// Changed in exactly the same way
+	size_t identical = 0;
+	/// Left in the same state, but from different previous versions
+	size_t compatible = 0;
+	/// Deleted by one and edited by the other, resolved by deleting them with ConflictPolicy::PreferDeletions
+	/// Otherwise these are conflicts
+	size_t deletedEdits = 0;
+	std::vector<MergeConflict> conflicts;
+};
+NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(MergeReport, identical, compatible, deletedEdits, conflicts);
+
 /// A collection of all the changes for type T in a network
 template <typename K, typename T> struct NetworkItemChanges {
 	std::map<K, T> deletions;
@@ -13,43 +62,277 @@ template <typename K, typename T> struct NetworkItemChanges {
 
 	/// Calculate the differences (changed, added and removed values) between `from` and `to`
 	/// and insert them into the correct maps
-	void diffMaps(const std::map<K, T> &from, const std::map<K, T> &to) {
-		// Transform the ID in the range to a pair<old,new>
-		auto editedTransform =
-		    std::views::transform([&](auto id) { return std::pair(id, std::pair(from.at(id), to.at(id))); });
-		// Transforms the IDs in the range into the value in the specific map
-		auto fromTransform = std::views::transform([&](auto id) { return std::pair(id, from.at(id)); });
-		auto toTransform = std::views::transform([&](auto id) { return std::pair(id, to.at(id)); });
-
-		// All the IDs in both maps
-		std::vector<K> preservedIDs;
-		std::ranges::set_intersection(std::views::keys(from), std::views::keys(to), std::back_inserter(preservedIDs));
-		// Only record if anything has changed
-		auto changedElements =
-		    preservedIDs | std::views::filter([&](const auto id) { return from.at(id) != to.at(id); });
-		std::ranges::copy(changedElements | editedTransform, std::inserter(edits, edits.end()));
-
-		// All the IDs only in the `from` map
-		std::vector<K> deletedIDs;
-		std::ranges::set_difference(std::views::keys(from), std::views::keys(to), std::back_inserter(deletedIDs));
-		std::ranges::copy(deletedIDs | fromTransform, std::inserter(deletions, deletions.end()));
-
-		// All the IDs only in the `to` map
-		std::vector<K> newIDs;
-		std::ranges::set_difference(std::views::keys(to), std::views::keys(from), std::back_inserter(newIDs));
-		std::ranges::copy(newIDs | toTransform, std::inserter(additions, additions.end()));
+	/// Works on any sorted map, with a single pass over both. Chunks shared between two versions of a
+	/// PersistentMap are skipped entirely, so diffing against a close descendant only costs as much as the changes
+	template <typename M> void diffMaps(const M &from, const M &to) {
+		auto fromIt = from.begin();
+		auto toIt = to.begin();
+		while (fromIt != from.end() && toIt != to.end()) {
+			if constexpr (requires { fromIt.sharesChunkWith(toIt); }) {
+				if (fromIt.sharesChunkWith(toIt)) {
+					fromIt.skipChunk();
+					toIt.skipChunk();
+					continue;
+				}
+			}
+
+			if (fromIt->first < toIt->first) {
+				deletions.emplace_hint(deletions.end(), fromIt->first, fromIt->second);
+				++fromIt;
+			} else if (toIt->first < fromIt->first) {
+				additions.emplace_hint(additions.end(), toIt->first, toIt->second);
+				++toIt;
+			} else {
+				// Only record if anything has changed
+				if (fromIt->second != toIt->second)
+					edits.emplace_hint(edits.end(), fromIt->first, std::pair(fromIt->second, toIt->second));
+				++fromIt;
+				++toIt;
+			}
+		}
+		for (; fromIt != from.end(); ++fromIt)
+			deletions.emplace_hint(deletions.end(), fromIt->first, fromIt->second);
+		for (; toIt != to.end(); ++toIt)
+			additions.emplace_hint(additions.end(), toIt->first, toIt->second);
+	}
+
+	/// Write a compact binary form, with every item in the same element format as the network files
+	void writeToFile(SplnetFileWriter &fileWriter) const {
+		fileWriter.write(static_cast<uint32_t>(deletions.size()));
+		for (const auto &item : deletions | std::views::values)
+			item.writeToFile(fileWriter);
+
+		fileWriter.write(static_cast<uint32_t>(additions.size()));
+		for (const auto &item : additions | std::views::values)
+			item.writeToFile(fileWriter);
+
+		fileWriter.write(static_cast<uint32_t>(edits.size()));
+		for (const auto &[oldItem, newItem] : edits | std::views::values) {
+			oldItem.writeToFile(fileWriter);
+			newItem.writeToFile(fileWriter);
+		}
+	}
+	/// Read the binary form written by writeToFile, `keyOf` gives the map key of an item
+	template <typename F> void readFromFile(SplnetFileReader &fileReader, F keyOf) {
+		for (auto count = fileReader.read<uint32_t>(); count > 0; --count) {
+			T item(fileReader);
+			deletions.emplace_hint(deletions.end(), keyOf(item), std::move(item));
+		}
+
+		for (auto count = fileReader.read<uint32_t>(); count > 0; --count) {
+			T item(fileReader);
+			additions.emplace_hint(additions.end(), keyOf(item), std::move(item));
+		}
+
+		for (auto count = fileReader.read<uint32_t>(); count > 0; --count) {
+			T oldItem(fileReader);
+			T newItem(fileReader);
+			edits.emplace_hint(edits.end(), keyOf(newItem), std::pair(std::move(oldItem), std::move(newItem)));
+		}
+	}
+
+	/// Combine the changes in several sources, in one k-way pass over all of them, which are moved from
+	/// `member` picks the changes out of a source. Overlaps are classified and resolved the same way as in merge
+	template <typename S>
+	static void combine(std::vector<S> &sources, NetworkItemChanges S::*member, NetworkItemChanges &combined,
+	                    ConflictPolicy policy, MergeReport &report) {
+		std::vector<NetworkItemChanges *> sides;
+		for (auto &source : sources)
+			sides.push_back(&(source.*member));
+		combined = join(sides, policy, report, [](size_t side) { return fmt::format("diff #{}", side + 1); });
+	}
+
+	/// Undo the changes, additions become deletions and the other way around, and edits go back to the old version
+	void invert() {
+		std::swap(additions, deletions);
+		for (auto &[oldItem, newItem] : edits | std::views::values)
+			std::swap(oldItem, newItem);
+	}
+
+	/// The changes in `first` followed by the ones in `second` as a single set of changes, in one pass over both,
+	/// which are moved from. Additions deleted again cancel out, chains of edits collapse into one,
+	/// and anything ending up as it started is dropped
+	/// Mismatched versions are warned about like when applying, while adding an item the first changes leave in
+	/// place is a conflict, which is printed and counted
+	static size_t compose(NetworkItemChanges &first, NetworkItemChanges &second, NetworkItemChanges &composed) {
+		const auto firstChanges = first.changesInOrder();
+		const auto secondChanges = second.changesInOrder();
+
+		size_t conflicts = 0;
+		auto a = firstChanges.begin();
+		auto b = secondChanges.begin();
+		while (a != firstChanges.end() || b != secondChanges.end()) {
+			if (b == secondChanges.end() || (a != firstChanges.end() && a->key < b->key)) {
+				composed.record(*a++);
+				continue;
+			}
+			if (a == firstChanges.end() || b->key < a->key) {
+				composed.record(*b++);
+				continue;
+			}
+
+			// Changed by both, from the version before the first change to the one after the second
+			if (a->after && !b->before) {
+				fmt::print(std::cerr, "{} is added by the second diff, but already exists after the first.\n",
+				           *b->after);
+				conflicts++;
+			} else if (!a->after && b->before) {
+				fmt::print(std::cerr,
+				           "{} is changed by the second diff after the first deleted it.\n"
+				           "\tThe change will still be kept, but take care.\n",
+				           *b->before);
+			} else if (a->after && *a->after != *b->before) {
+				fmt::print(std::cerr,
+				           "{} data does not match the version left by the first diff.\n"
+				           "\tThis is not necessarily a problem, some nodes may just have been nudged, but be "
+				           "careful.\n",
+				           *b->before);
+			}
+			composed.record({a->key, a->before, b->after});
+			++a;
+			++b;
+		}
+		return conflicts;
+	}
+
+	/// Merges other into this in one pass over both, which are moved from
+	/// Every item changed by both is added to `report`, and conflicts are resolved according to `policy`,
+	/// keeping the version in this if it can't, for the caller to refuse the result
+	void merge(NetworkItemChanges &other, ConflictPolicy policy, MergeReport &report) {
+		*this = join({this, &other}, policy, report,
+		             [](size_t side) { return std::string(side == 0 ? "the first side" : "the second side"); });
+	}
+
+private:
+	/// One item's change, the version before it is missing for additions, and the version after for deletions
+	struct Change {
+		K key;
+		T *before;
+		T *after;
+	};
+
+	/// Every change, sorted by key, pointing into the maps
+	std::vector<Change> changesInOrder() {
+		std::vector<Change> changes;
+		changes.reserve(deletions.size() + additions.size() + edits.size());
+
+		auto deletion = deletions.begin();
+		auto addition = additions.begin();
+		auto edit = edits.begin();
+		while (deletion != deletions.end() || addition != additions.end() || edit != edits.end()) {
+			const K *key = nullptr;
+			for (const K *candidate : {deletion != deletions.end() ? &deletion->first : nullptr,
+			                           addition != additions.end() ? &addition->first : nullptr,
+			                           edit != edits.end() ? &edit->first : nullptr}) {
+				if (candidate && (!key || *candidate < *key))
+					key = candidate;
+			}
+
+			Change change{*key, nullptr, nullptr};
+			if (edit != edits.end() && edit->first == change.key) {
+				change.before = &edit->second.first;
+				change.after = &edit->second.second;
+				++edit;
+			}
+			if (deletion != deletions.end() && deletion->first == change.key) {
+				change.before = &deletion->second;
+				++deletion;
+			}
+			if (addition != additions.end() && addition->first == change.key) {
+				change.after = &addition->second;
+				++addition;
+			}
+			changes.push_back(change);
+		}
+		return changes;
+	}
+	static std::string_view action(const Change &change) {
+		return !change.before ? "added" : !change.after ? "deleted" : "edited";
+	}
+	/// Add a change to the end of the maps, its key has to be after any already in them
+	void record(const Change &change) {
+		if (change.before && change.after) {
+			if (*change.before != *change.after)
+				edits.emplace_hint(edits.end(), change.key,
+				                   std::pair(std::move(*change.before), std::move(*change.after)));
+		} else if (change.before) {
+			deletions.emplace_hint(deletions.end(), change.key, std::move(*change.before));
+		} else if (change.after) {
+			additions.emplace_hint(additions.end(), change.key, std::move(*change.after));
+		}
+	}
+
+	/// Join the changes of every side in one pass over all of them, which are moved from
+	/// Items changed by more than one side are classified one side at a time against the change kept so far,
+	/// `sideName` names a side by its index in messages
+	template <typename F>
+	static NetworkItemChanges join(const std::vector<NetworkItemChanges *> &sides, ConflictPolicy policy,
+	                               MergeReport &report, F sideName) {
+		std::vector<std::vector<Change>> changes;
+		std::vector<typename std::vector<Change>::const_iterator> heads;
+		changes.reserve(sides.size());
+		for (auto *side : sides) {
+			changes.push_back(side->changesInOrder());
+			heads.push_back(changes.back().begin());
+		}
+
+		NetworkItemChanges joined;
+		while (true) {
+			// The smallest key at the head of any side
+			std::optional<K> key;
+			for (size_t i = 0; i < heads.size(); ++i) {
+				if (heads[i] != changes[i].end() && (!key || heads[i]->key < *key))
+					key = heads[i]->key;
+			}
+			if (!key)
+				break;
+
+			std::optional<size_t> kept;
+			for (size_t i = 0; i < heads.size(); ++i) {
+				if (heads[i] == changes[i].end() || heads[i]->key != *key)
+					continue;
+				if (!kept || resolve(*heads[*kept], *heads[i], policy, report, sideName(*kept), sideName(i)))
+					kept = i;
+			}
+			joined.record(*heads[*kept]);
+			for (size_t i = 0; i < heads.size(); ++i) {
+				if (heads[i] != changes[i].end() && heads[i]->key == *key)
+					++heads[i];
+			}
+		}
+		return joined;
 	}
+	/// Classify an item changed by two sides and add it to `report`, returns whether to keep the second change
+	static bool resolve(const Change &first, const Change &second, ConflictPolicy policy, MergeReport &report,
+	                    std::string_view firstName, std::string_view secondName) {
+		const auto sameVersion = [](const T *a, const T *b) { return a && b ? *a == *b : a == b; };
+		if (sameVersion(first.after, second.after)) {
+			if (sameVersion(first.before, second.before))
+				report.identical++;
+			else
+				report.compatible++;
+			return false;
+		}
 
-	/// Merges other into this
-	/// Will (silently) prefer this over other
-	void merge(NetworkItemChanges &other) {
-		// TODO: Sanity check edits and deletions,
-		//  so nothing gets overwritten silently,
-		//  or deletes something in a previous diff
+		const auto &item = first.after ? *first.after : *first.before;
+		const bool deletedEdit = first.before && second.before && !first.after != !second.after;
+		if (deletedEdit && policy == ConflictPolicy::PreferDeletions) {
+			fmt::print(std::cerr, "{} is {} by {} and {} by {}, it will be deleted.\n", item, action(first), firstName,
+			           action(second), secondName);
+			report.deletedEdits++;
+			return !second.after;
+		}
 
-		deletions.merge(other.deletions);
-		additions.merge(other.additions);
-		edits.merge(other.edits);
+		const auto &conflict = report.conflicts.emplace_back(MergeConflict{
+		    fmt::format("{}", item), std::string(action(first)), std::string(action(second)),
+		    first.after ? nlohmann::json(*first.after) : nlohmann::json(),
+		    second.after ? nlohmann::json(*second.after) : nlohmann::json()});
+		fmt::print(std::cerr, "{} is {} by {} and {} by {}{}.\n", conflict.item, conflict.firstAction, firstName,
+		           conflict.secondAction, secondName,
+		           policy == ConflictPolicy::PreferFirst  ? fmt::format(", keeping the version from {}", firstName)
+		           : policy == ConflictPolicy::PreferLast ? fmt::format(", keeping the version from {}", secondName)
+		                                                  : "");
+		return policy == ConflictPolicy::PreferLast;
 	}
 };
 template <typename K, typename T> void to_json(nlohmann::json &json, const NetworkItemChanges<K, T> &changeList) {
@@ -0,0 +1,265 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+/// A sorted map stored as a list of shared chunks of sorted items
+/// Copies share every chunk, and a chunk is only copied once it is changed while shared,
+/// so a copy with a few changes costs memory and time in proportion to the changes, not the size of the map
+/// Chunks are split once they reach 2 * ChunkSize items and joined with a neighbour once they fall below ChunkSize / 2,
+/// so unless there is only one chunk every chunk holds ChunkSize / 2 to 2 * ChunkSize - 1 items
+/// Read-only use is thread-safe, changing copies on different threads is not
+template <typename K, typename V, size_t ChunkSize = 64> class PersistentMap {
+public:
+	using key_type = K;
+	using mapped_type = V;
+	using value_type = std::pair<K, V>;
+
+private:
+	using Chunk = std::vector<value_type>;
+
+	// No chunk is ever empty, and every key is smaller than every key in the following chunks
+	std::vector<std::shared_ptr<Chunk>> _chunks;
+	size_t _size = 0;
+
+	/// The chunk `key` belongs in, the first if it is before everything
+	[[nodiscard]] size_t chunkFor(const K &key) const {
+		auto it = std::upper_bound(_chunks.begin(), _chunks.end(), key,
+		                           [](const K &k, const auto &chunk) { return k < chunk->front().first; });
+		return it == _chunks.begin() ? 0 : static_cast<size_t>(it - _chunks.begin()) - 1;
+	}
+	template <typename C> static auto lowerBound(C &chunk, const K &key) {
+		return std::lower_bound(chunk.begin(), chunk.end(), key,
+		                        [](const value_type &item, const K &k) { return item.first < k; });
+	}
+	/// The chunk at `index`, copied first if any other map shares it
+	Chunk &mutableChunk(size_t index) {
+		if (_chunks[index].use_count() > 1)
+			_chunks[index] = std::make_shared<Chunk>(*_chunks[index]);
+		return *_chunks[index];
+	}
+	/// Split the chunk at `index` in half once it has grown too big
+	void balance(size_t index) {
+		auto &chunk = *_chunks[index];
+		if (chunk.size() < 2 * ChunkSize)
+			return;
+
+		const auto middle = chunk.begin() + static_cast<std::ptrdiff_t>(chunk.size() / 2);
+		auto second = std::make_shared<Chunk>(std::make_move_iterator(middle), std::make_move_iterator(chunk.end()));
+		chunk.erase(middle, chunk.end());
+		_chunks.insert(_chunks.begin() + static_cast<std::ptrdiff_t>(index) + 1, std::move(second));
+	}
+	/// Join the chunk at `index` with a neighbour once it has shrunk too small, splitting them again if too big
+	/// Otherwise deletions would leave many tiny chunks, which share and skip far less than full ones
+	void join(size_t index) {
+		if (_chunks.size() < 2 || _chunks[index]->size() >= ChunkSize / 2)
+			return;
+
+		// Into the chunk before, unless it is the first one
+		const auto first = index > 0 ? index - 1 : index;
+		auto &into = mutableChunk(first);
+		const auto next = _chunks.begin() + static_cast<std::ptrdiff_t>(first) + 1;
+		if (next->use_count() > 1) {
+			into.insert(into.end(), (*next)->begin(), (*next)->end());
+		} else {
+			into.insert(into.end(), std::make_move_iterator((*next)->begin()),
+			            std::make_move_iterator((*next)->end()));
+		}
+		_chunks.erase(next);
+		balance(first);
+	}
+
+public:
+	class const_iterator {
+		const PersistentMap *_map = nullptr;
+		size_t _chunk = 0;
+		size_t _item = 0;
+
+		friend class PersistentMap;
+		const_iterator(const PersistentMap *map, size_t chunk, size_t item)
+		    : _map(map)
+		    , _chunk(chunk)
+		    , _item(item) {}
+
+	public:
+		using iterator_category = std::bidirectional_iterator_tag;
+		using value_type = PersistentMap::value_type;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const value_type *;
+		using reference = const value_type &;
+
+		const_iterator() = default;
+
+		reference operator*() const { return (*_map->_chunks[_chunk])[_item]; }
+		pointer operator->() const { return &**this; }
+
+		const_iterator &operator++() {
+			if (++_item == _map->_chunks[_chunk]->size()) {
+				++_chunk;
+				_item = 0;
+			}
+			return *this;
+		}
+		const_iterator operator++(int) {
+			auto copy = *this;
+			++*this;
+			return copy;
+		}
+		const_iterator &operator--() {
+			if (_item == 0)
+				_item = _map->_chunks[--_chunk]->size();
+			--_item;
+			return *this;
+		}
+		const_iterator operator--(int) {
+			auto copy = *this;
+			--*this;
+			return copy;
+		}
+
+		bool operator==(const const_iterator &other) const { return _chunk == other._chunk && _item == other._item; }
+
+		/// Whether both iterators are at the start of the same shared chunk, so the next items are all identical
+		[[nodiscard]] bool sharesChunkWith(const const_iterator &other) const {
+			return _item == 0 && other._item == 0 && _chunk < _map->_chunks.size() &&
+			       other._chunk < other._map->_chunks.size() &&
+			       _map->_chunks[_chunk] == other._map->_chunks[other._chunk];
+		}
+		/// Skip past the rest of the current chunk
+		void skipChunk() {
+			++_chunk;
+			_item = 0;
+		}
+	};
+	using iterator = const_iterator;
+
+	PersistentMap() = default;
+
+	[[nodiscard]] size_t size() const { return _size; }
+	[[nodiscard]] bool empty() const { return _size == 0; }
+	[[nodiscard]] size_t chunkCount() const { return _chunks.size(); }
+	/// How many chunks are shared with `other`, for checking how much a copy has diverged
+	[[nodiscard]] size_t sharedChunks(const PersistentMap &other) const {
+		size_t shared = 0;
+		auto otherIt = other._chunks.begin();
+		for (const auto &chunk : _chunks) {
+			while (otherIt != other._chunks.end() && (*otherIt)->front().first < chunk->front().first)
+				++otherIt;
+			if (otherIt != other._chunks.end() && *otherIt == chunk)
+				shared++;
+		}
+		return shared;
+	}
+
+	[[nodiscard]] const_iterator begin() const { return {this, 0, 0}; }
+	[[nodiscard]] const_iterator end() const { return {this, _chunks.size(), 0}; }
+	[[nodiscard]] const_iterator cbegin() const { return begin(); }
+	[[nodiscard]] const_iterator cend() const { return end(); }
+
+	[[nodiscard]] const_iterator find(const K &key) const {
+		if (_chunks.empty())
+			return end();
+		const auto chunkIndex = chunkFor(key);
+		const auto &chunk = *_chunks[chunkIndex];
+		auto it = lowerBound(chunk, key);
+		if (it == chunk.end() || it->first != key)
+			return end();
+		return {this, chunkIndex, static_cast<size_t>(it - chunk.begin())};
+	}
+	[[nodiscard]] bool contains(const K &key) const { return find(key) != end(); }
+	[[nodiscard]] const V &at(const K &key) const {
+		auto it = find(key);
+		if (it == end())
+			throw std::out_of_range("PersistentMap::at");
+		return it->second;
+	}
+
+	/// Insert the item if the key isn't already in the map, returns whether it was inserted
+	bool emplace(const K &key, V value) {
+		if (_chunks.empty()) {
+			_chunks.push_back(std::make_shared<Chunk>());
+			_chunks.back()->emplace_back(key, std::move(value));
+			_size++;
+			return true;
+		}
+
+		const auto chunkIndex = chunkFor(key);
+		{
+			// Don't copy a shared chunk just to find the key is already there
+			const auto &chunk = *_chunks[chunkIndex];
+			auto it = lowerBound(chunk, key);
+			if (it != chunk.end() && it->first == key)
+				return false;
+		}
+
+		auto &chunk = mutableChunk(chunkIndex);
+		chunk.emplace(lowerBound(chunk, key), key, std::move(value));
+		_size++;
+		balance(chunkIndex);
+		return true;
+	}
+	/// Insert the item, or replace the value if the key is already in the map
+	void insert_or_assign(const K &key, V value) {
+		if (_chunks.empty()) {
+			emplace(key, std::move(value));
+			return;
+		}
+
+		const auto chunkIndex = chunkFor(key);
+		auto &chunk = mutableChunk(chunkIndex);
+		auto it = lowerBound(chunk, key);
+		if (it != chunk.end() && it->first == key) {
+			it->second = std::move(value);
+			return;
+		}
+		chunk.emplace(it, key, std::move(value));
+		_size++;
+		balance(chunkIndex);
+	}
+	/// Returns the number of items removed
+	size_t erase(const K &key) {
+		auto it = find(key);
+		if (it == end())
+			return 0;
+		erase(it);
+		return 1;
+	}
+	void erase(const_iterator position) {
+		auto &chunk = mutableChunk(position._chunk);
+		chunk.erase(chunk.begin() + static_cast<std::ptrdiff_t>(position._item));
+		_size--;
+		if (chunk.empty())
+			_chunks.erase(_chunks.begin() + static_cast<std::ptrdiff_t>(position._chunk));
+		else
+			join(position._chunk);
+	}
+	void clear() {
+		_chunks.clear();
+		_size = 0;
+	}
+
+	bool operator==(const PersistentMap &other) const {
+		return _size == other._size && std::equal(begin(), end(), other.begin());
+	}
+};
+
+/// Same format as nlohmann uses for a std::map with non-string keys, an array of [key, value] pairs
+template <typename K, typename V, size_t N> void to_json(nlohmann::json &json, const PersistentMap<K, V, N> &map) {
+	json = nlohmann::json::array();
+	for (const auto &item : map)
+		json.push_back(item);
+}
+template <typename K, typename V, size_t N> void from_json(const nlohmann::json &json, PersistentMap<K, V, N> &map) {
+	map.clear();
+	for (const auto &item : json) {
+		auto [key, value] = item.get<std::pair<K, V>>();
+		map.emplace(key, std::move(value));
+	}
+}
@@ -21,6 +21,8 @@ public:
 
 	[[nodiscard]] auto id() const { return _id; }
 	void id(uint32_t set) { _id = set; }
+	[[nodiscard]] const auto &anchors() const { return _anchors; }
+	void anchors(std::vector<uint32_t> set) { _anchors = std::move(set); }
 
 	void remapAnchors(const std::map<uint32_t, uint32_t> &map);
 
@@ -0,0 +1,145 @@
+#include "RouteDeduplicator.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <ranges>
+#include <unordered_set>
+#include <utility>
+
+size_t RouteDeduplicator::SignatureHash::operator()(const std::vector<uint64_t> &signature) const {
+	size_t hash = signature.size();
+	for (const auto value : signature)
+		hash ^= std::hash<uint64_t>{}(value) + 0x9e3779b97f4a7c15 + (hash << 6) + (hash >> 2);
+	return hash;
+}
+
+RouteDeduplicator::RouteDeduplicator(AnchorLookup anchorLookup)
+    : _anchorLookup(std::move(anchorLookup)) {}
+
+std::vector<uint64_t> RouteDeduplicator::signature(const Route &route) const {
+	std::vector<uint64_t> signature;
+	signature.reserve(1 + 2 * route.anchors().size());
+	signature.push_back(route.id() & 0xFF);
+	for (const auto id : route.anchors()) {
+		// Ids never use bit 32, so a marker with it set followed by a position can't be mistaken for one
+		const auto *anchor = _anchorLookup(id);
+		if (anchor && anchor->isSubAnchor()) {
+			signature.push_back(uint64_t(1) << 32 | static_cast<uint64_t>(anchor->isWaterAnchor()));
+			signature.push_back(static_cast<uint64_t>(std::bit_cast<uint32_t>(anchor->posX())) << 32 |
+			                    std::bit_cast<uint32_t>(anchor->posY()));
+		} else {
+			signature.push_back(id);
+		}
+	}
+	return signature;
+}
+
+bool RouteDeduplicator::add(const Route &route) {
+	auto [it, inserted] = _survivors.emplace(signature(route), route.id());
+	if (inserted)
+		return false;
+	_duplicates.emplace(route.id(), it->second);
+	return true;
+}
+
+bool RouteDeduplicator::rewrite(Strip &strip) const {
+	std::vector<uint64_t> routeIDs;
+	for (auto id : strip.routeIDs()) {
+		auto it = _duplicates.find(static_cast<uint32_t>(id));
+		if (it != _duplicates.end())
+			id = it->second;
+		if (std::ranges::find(routeIDs, id) == routeIDs.end())
+			routeIDs.push_back(id);
+	}
+	if (routeIDs == strip.routeIDs())
+		return false;
+	strip.routeIDs(std::move(routeIDs));
+	return true;
+}
+
+Diff RouteDeduplicator::deduplicate(const SplineNetwork &network) {
+	RouteDeduplicator deduplicator([&](uint32_t id) -> const Anchor * {
+		auto it = network.anchors().find(id);
+		return it == network.anchors().end() ? nullptr : &it->second;
+	});
+
+	Diff diff;
+	std::unordered_set<uint32_t> removed;
+	std::unordered_set<uint32_t> used;
+	for (const auto &route : network.routes() | std::views::values) {
+		if (deduplicator.add(route)) {
+			diff.routeChanges.deletions.emplace_hint(diff.routeChanges.deletions.end(), route.id(), route);
+			removed.insert(route.anchors().begin(), route.anchors().end());
+		} else {
+			used.insert(route.anchors().begin(), route.anchors().end());
+		}
+	}
+
+	// Every strip is kept, the key already makes them unique and a strip running the other way is a different one,
+	// even if it uses the same routes
+	for (const auto &[key, strip] : network.strips()) {
+		auto rewritten = strip;
+		if (deduplicator.rewrite(rewritten))
+			diff.stripChanges.edits.emplace_hint(diff.stripChanges.edits.end(), key, std::pair(strip, rewritten));
+	}
+
+	// Sub-anchors shared with a surviving route have to stay for that one, and hub anchors always do
+	for (const auto id : removed) {
+		if (used.contains(id))
+			continue;
+		auto it = network.anchors().find(id);
+		if (it != network.anchors().end() && it->second.isSubAnchor())
+			diff.anchorChanges.deletions.emplace(id, it->second);
+	}
+
+	return diff;
+}
+
+size_t RouteDeduplicator::deduplicate(Diff &diff, const Diff &onto) {
+	RouteDeduplicator deduplicator([&](uint32_t id) -> const Anchor * {
+		for (const auto *changes : {&onto.anchorChanges, &std::as_const(diff.anchorChanges)}) {
+			auto it = changes->additions.find(id);
+			if (it != changes->additions.end())
+				return &it->second;
+		}
+		return nullptr;
+	});
+	// Duplicates within `onto` are left alone, its strips still use them
+	for (const auto &route : onto.routeChanges.additions | std::views::values)
+		deduplicator.add(route);
+	deduplicator._duplicates.clear();
+
+	std::unordered_set<uint32_t> removed;
+	auto &routes = diff.routeChanges.additions;
+	for (auto it = routes.begin(); it != routes.end();) {
+		if (deduplicator.add(it->second)) {
+			removed.insert(it->second.anchors().begin(), it->second.anchors().end());
+			it = routes.erase(it);
+		} else {
+			++it;
+		}
+	}
+	if (deduplicator.duplicates().empty())
+		return 0;
+
+	for (const auto &route : routes | std::views::values) {
+		for (const auto id : route.anchors())
+			removed.erase(id);
+	}
+	for (const auto &route : diff.routeChanges.edits | std::views::values) {
+		for (const auto id : route.second.anchors())
+			removed.erase(id);
+	}
+	for (const auto id : removed) {
+		auto it = diff.anchorChanges.additions.find(id);
+		if (it != diff.anchorChanges.additions.end() && it->second.isSubAnchor())
+			diff.anchorChanges.additions.erase(it);
+	}
+
+	for (auto &strip : diff.stripChanges.additions | std::views::values)
+		deduplicator.rewrite(strip);
+	for (auto &strip : diff.stripChanges.edits | std::views::values)
+		deduplicator.rewrite(strip.second);
+
+	return deduplicator.duplicates().size();
+}
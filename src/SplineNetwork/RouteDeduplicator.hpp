@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+#include "Diff.hpp"
+#include "SplineNetwork.hpp"
+
+/// Finds routes running through the same anchors under different ids, and points strips at the surviving ones
+/// Sub-anchors are compared by position rather than id, since merging networks renumbers them
+class RouteDeduplicator {
+public:
+	/// The anchor with an id, or null if it isn't known
+	using AnchorLookup = std::function<const Anchor *(uint32_t)>;
+
+private:
+	struct SignatureHash {
+		size_t operator()(const std::vector<uint64_t> &signature) const;
+	};
+
+	AnchorLookup _anchorLookup;
+	/// The route type followed by its anchors, to the first route seen with it
+	std::unordered_map<std::vector<uint64_t>, uint32_t, SignatureHash> _survivors;
+	/// Duplicate route to the route it is a duplicate of
+	std::map<uint32_t, uint32_t> _duplicates;
+
+	[[nodiscard]] std::vector<uint64_t> signature(const Route &route) const;
+
+public:
+	explicit RouteDeduplicator(AnchorLookup anchorLookup);
+
+	/// Returns true if an identical route has been added before, otherwise it is kept as the surviving version
+	bool add(const Route &route);
+	[[nodiscard]] const auto &duplicates() const { return _duplicates; }
+	/// Point the strip at the surviving routes, dropping any listed twice. Returns whether anything changed
+	bool rewrite(Strip &strip) const;
+
+	/// The changes removing every duplicate route from the network, along with the sub-anchors only they used,
+	/// and pointing the strips at the surviving routes
+	[[nodiscard]] static Diff deduplicate(const SplineNetwork &network);
+	/// Drop the routes `diff` adds that duplicate ones `onto` adds, or each other, along with the sub-anchors only they
+	/// used, and point its strips at the surviving routes. Returns the number of routes dropped
+	static size_t deduplicate(Diff &diff, const Diff &onto);
+};
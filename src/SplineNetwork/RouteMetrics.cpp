@@ -0,0 +1,160 @@
+#include "RouteMetrics.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <fstream>
+#include <numbers>
+#include <ranges>
+
+#include <fmt/ostream.h>
+
+#include "SimdFloat.hpp"
+
+namespace {
+	/// Line segments each spline segment is split into when measuring its length
+	constexpr int lengthSamples = 8;
+
+	/// The four control points of every spline segment, one array per coordinate
+	struct Segments {
+		std::vector<float> x0, y0, x1, y1, x2, y2, x3, y3;
+
+		void push_back(size_t p0, size_t p1, size_t p2, size_t p3, const std::vector<float> &x,
+		               const std::vector<float> &y) {
+			x0.push_back(x[p0]);
+			y0.push_back(y[p0]);
+			x1.push_back(x[p1]);
+			y1.push_back(y[p1]);
+			x2.push_back(x[p2]);
+			y2.push_back(y[p2]);
+			x3.push_back(x[p3]);
+			y3.push_back(y[p3]);
+		}
+		[[nodiscard]] size_t size() const { return x0.size(); }
+	};
+
+	using simd::Float1;
+	using simd::FloatN;
+
+	/// Measure segments [begin, end) `V::width` at a time, `end - begin` has to be a multiple of the width
+	/// Writes the length along the spline and the straight distance between the two middle control points
+	template <typename V>
+	void measureSegments(const Segments &s, size_t begin, size_t end, float *lengths, float *chords) {
+		const auto half = V::broadcast(0.5f);
+		const auto two = V::broadcast(2);
+		const auto three = V::broadcast(3);
+		const auto four = V::broadcast(4);
+		const auto five = V::broadcast(5);
+
+		for (size_t i = begin; i < end; i += V::width) {
+			// The spline segment as a cubic polynomial per axis, c0 + c1 t + c2 t^2 + c3 t^3
+			auto coefficients = [&](const std::vector<float> &p0, const std::vector<float> &p1,
+			                        const std::vector<float> &p2, const std::vector<float> &p3) {
+				const auto a = V::load(&p0[i]);
+				const auto b = V::load(&p1[i]);
+				const auto c = V::load(&p2[i]);
+				const auto d = V::load(&p3[i]);
+				return std::array{b, half * (c - a), half * (two * a - five * b + four * c - d),
+				                  half * (three * (b - c) + d - a)};
+			};
+			const auto cx = coefficients(s.x0, s.x1, s.x2, s.x3);
+			const auto cy = coefficients(s.y0, s.y1, s.y2, s.y3);
+
+			auto previousX = cx[0];
+			auto previousY = cy[0];
+			auto length = V::broadcast(0);
+			for (int sample = 1; sample <= lengthSamples; ++sample) {
+				const auto t = V::broadcast(static_cast<float>(sample) / lengthSamples);
+				const auto x = cx[0] + t * (cx[1] + t * (cx[2] + t * cx[3]));
+				const auto y = cy[0] + t * (cy[1] + t * (cy[2] + t * cy[3]));
+				const auto dx = x - previousX;
+				const auto dy = y - previousY;
+				length = length + sqrt(dx * dx + dy * dy);
+				previousX = x;
+				previousY = y;
+			}
+			length.store(&lengths[i]);
+
+			const auto dx = V::load(&s.x2[i]) - V::load(&s.x1[i]);
+			const auto dy = V::load(&s.y2[i]) - V::load(&s.y1[i]);
+			sqrt(dx * dx + dy * dy).store(&chords[i]);
+		}
+	}
+} // namespace
+
+RouteMetrics::RouteMetrics(const SplineNetwork &network) {
+	// Every route's anchor positions back to back, route `n` is [offsets[n], offsets[n + 1])
+	std::vector<float> x;
+	std::vector<float> y;
+	std::vector<size_t> offsets = {0};
+	for (const auto &[id, route] : network.routes()) {
+		auto &metrics = _routes.emplace_back(Metrics{id});
+		for (const auto anchorID : route.anchors()) {
+			auto it = network.anchors().find(anchorID);
+			if (it == network.anchors().end()) {
+				metrics.missingAnchors++;
+				continue;
+			}
+			x.push_back(it->second.posX());
+			y.push_back(it->second.posY());
+		}
+		offsets.push_back(x.size());
+		metrics.anchorCount = static_cast<uint32_t>(offsets.back() - offsets[offsets.size() - 2]);
+	}
+
+	// The control points of every segment, with the ends of the route repeated like the renderer does
+	Segments segments;
+	for (size_t n = 0; n < _routes.size(); ++n) {
+		const auto first = offsets[n];
+		if (offsets[n + 1] - first < 2)
+			continue;
+		const auto last = offsets[n + 1] - 1;
+		for (size_t i = first; i < last; ++i)
+			segments.push_back(i == first ? i : i - 1, i, i + 1, std::min(i + 2, last), x, y);
+	}
+
+	std::vector<float> lengths(segments.size());
+	std::vector<float> chords(segments.size());
+	const auto vectorEnd = segments.size() - segments.size() % FloatN::width;
+	measureSegments<FloatN>(segments, 0, vectorEnd, lengths.data(), chords.data());
+	measureSegments<Float1>(segments, vectorEnd, segments.size(), lengths.data(), chords.data());
+
+	size_t segment = 0;
+	for (size_t n = 0; n < _routes.size(); ++n) {
+		auto &metrics = _routes[n];
+		const auto first = offsets[n];
+		const auto count = offsets[n + 1] - first;
+		if (count == 0)
+			continue;
+
+		metrics.chord = std::hypot(x[first + count - 1] - x[first], y[first + count - 1] - y[first]);
+		for (size_t i = 0; i + 1 < count; ++i, ++segment) {
+			metrics.length += lengths[segment];
+			if (chords[segment] < stackedDistance)
+				metrics.stackedAnchors++;
+		}
+
+		// The turn at every interior anchor, between the directions in and out of it
+		for (size_t i = first + 1; i + 1 < first + count; ++i) {
+			const auto inX = x[i] - x[i - 1];
+			const auto inY = y[i] - y[i - 1];
+			const auto outX = x[i + 1] - x[i];
+			const auto outY = y[i + 1] - y[i];
+			const auto turn = std::abs(std::atan2(inX * outY - inY * outX, inX * outX + inY * outY)) * 180 /
+			                  std::numbers::pi_v<float>;
+			metrics.totalTurn += turn;
+			metrics.maxTurn = std::max(metrics.maxTurn, turn);
+		}
+	}
+}
+
+void RouteMetrics::writeCsv(const std::filesystem::path &path) const {
+	std::ofstream outputFile(path);
+	outputFile.exceptions(std::ios::failbit | std::ios::badbit);
+
+	fmt::print(outputFile, "route,anchors,segments,length,chord,total_turn,max_turn,stacked_anchors,missing_anchors\n");
+	for (const auto &m : _routes) {
+		fmt::print(outputFile, "{},{},{},{:.3f},{:.3f},{:.2f},{:.2f},{},{}\n", m.routeID, m.anchorCount,
+		           m.segmentCount(), m.length, m.chord, m.totalTurn, m.maxTurn, m.stackedAnchors, m.missingAnchors);
+	}
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+#include "SplineNetwork.hpp"
+
+/// Geometry measurements of every route, along the same Catmull-Rom spline the renderer draws
+/// The positions of all routes are gathered into contiguous arrays first, and measured with batch kernels over them
+class RouteMetrics {
+public:
+	struct Metrics {
+		uint32_t routeID;
+		/// Anchors found in the network, the route has anchorCount - 1 segments
+		uint32_t anchorCount = 0;
+		uint32_t missingAnchors = 0;
+		/// Anchors on top of the previous one in the route
+		uint32_t stackedAnchors = 0;
+		/// Along the spline
+		float length = 0;
+		/// Straight between the first and last anchor
+		float chord = 0;
+		/// The sum and largest of the turns at each anchor, in degrees
+		float totalTurn = 0;
+		float maxTurn = 0;
+
+		[[nodiscard]] uint32_t segmentCount() const { return anchorCount > 0 ? anchorCount - 1 : 0; }
+	};
+
+private:
+	std::vector<Metrics> _routes;
+
+public:
+	/// Anchors closer than this to the previous one are counted as stacked
+	static constexpr float stackedDistance = 0.01f;
+
+	explicit RouteMetrics(const SplineNetwork &network);
+
+	/// In the same order as the routes in the network
+	[[nodiscard]] const auto &routes() const { return _routes; }
+
+	void writeCsv(const std::filesystem::path &path) const;
+};
@@ -0,0 +1,176 @@
+#include "RouteSimplifier.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <thread>
+#include <unordered_set>
+
+#include "SimdFloat.hpp"
+
+namespace {
+	/// The squared distance from the points [begin, end) in (x, y) to the segment from (x0, y0) along (dx, dy),
+	/// `V::width` at a time, `end - begin` has to be a multiple of the width
+	template <typename V>
+	void segmentDistances(const float *x, const float *y, float *distances, size_t begin, size_t end, float x0,
+	                      float y0, float dx, float dy, float inverseLength) {
+		const auto startX = V::broadcast(x0);
+		const auto startY = V::broadcast(y0);
+		const auto alongX = V::broadcast(dx);
+		const auto alongY = V::broadcast(dy);
+		const auto inverse = V::broadcast(inverseLength);
+		const auto zero = V::broadcast(0);
+		const auto one = V::broadcast(1);
+		for (size_t i = begin; i < end; i += V::width) {
+			const auto px = V::load(&x[i]) - startX;
+			const auto py = V::load(&y[i]) - startY;
+			const auto t = min(max((px * alongX + py * alongY) * inverse, zero), one);
+			const auto ex = px - t * alongX;
+			const auto ey = py - t * alongY;
+			(ex * ex + ey * ey).store(&distances[i]);
+		}
+	}
+	/// The squared distance from every point in (x, y) to the segment from the first to the last point
+	void segmentDistances(std::span<const float> x, std::span<const float> y, std::span<float> distances) {
+		const float x0 = x.front();
+		const float y0 = y.front();
+		const float dx = x.back() - x0;
+		const float dy = y.back() - y0;
+		const float lengthSquared = dx * dx + dy * dy;
+		// A zero length segment is a point, projecting everything onto its start
+		const float inverseLength = lengthSquared > 0 ? 1 / lengthSquared : 0;
+
+		const auto vectorEnd = x.size() - x.size() % simd::FloatN::width;
+		segmentDistances<simd::FloatN>(x.data(), y.data(), distances.data(), 0, vectorEnd, x0, y0, dx, dy,
+		                               inverseLength);
+		segmentDistances<simd::Float1>(x.data(), y.data(), distances.data(), vectorEnd, x.size(), x0, y0, dx, dy,
+		                               inverseLength);
+	}
+} // namespace
+
+RouteSimplifier::RouteSimplifier(const SplineNetwork &network, float tolerance)
+    : _network(network)
+    , _tolerance(tolerance) {}
+
+std::vector<uint32_t> RouteSimplifier::simplifyRoute(const Route &route) const {
+	const auto &ids = route.anchors();
+	const auto &anchors = _network.anchors();
+
+	// Positions in contiguous arrays, and which anchors have to stay
+	// Hub anchors are the ends of the stretches everything else is measured against, so they need positions too
+	std::vector<float> x(ids.size());
+	std::vector<float> y(ids.size());
+	std::vector<bool> keep(ids.size(), false);
+	std::vector<bool> missing(ids.size(), false);
+	for (size_t i = 0; i < ids.size(); ++i) {
+		auto it = anchors.find(ids[i]);
+		if (it == anchors.end()) {
+			keep[i] = true;
+			missing[i] = true;
+			continue;
+		}
+		x[i] = it->second.posX();
+		y[i] = it->second.posY();
+		if (!it->second.isSubAnchor())
+			keep[i] = true;
+	}
+	keep.front() = true;
+	keep.back() = true;
+
+	// Simplify every stretch between two fixed anchors on its own, so the fixed ones can't be skipped over
+	const auto toleranceSquared = _tolerance * _tolerance;
+	std::vector<float> distances(ids.size());
+	std::vector<std::pair<size_t, size_t>> stack;
+	for (size_t start = 0, end = 1; end < ids.size(); ++end) {
+		if (!keep[end])
+			continue;
+		// Without a position for either end there is nothing to measure the stretch against, so all of it stays
+		if (missing[start] || missing[end]) {
+			std::fill(keep.begin() + static_cast<std::ptrdiff_t>(start),
+			          keep.begin() + static_cast<std::ptrdiff_t>(end), true);
+			start = end;
+			continue;
+		}
+		stack.emplace_back(start, end);
+		start = end;
+
+		while (!stack.empty()) {
+			const auto [first, last] = stack.back();
+			stack.pop_back();
+			if (last - first < 2)
+				continue;
+
+			const auto count = last - first + 1;
+			segmentDistances(std::span(x).subspan(first, count), std::span(y).subspan(first, count),
+			                 std::span(distances).subspan(first, count));
+			const auto furthest = static_cast<size_t>(
+			    std::max_element(distances.begin() + first + 1, distances.begin() + last) - distances.begin());
+			if (distances[furthest] <= toleranceSquared)
+				continue;
+
+			keep[furthest] = true;
+			stack.emplace_back(first, furthest);
+			stack.emplace_back(furthest, last);
+		}
+	}
+
+	std::vector<uint32_t> simplified;
+	for (size_t i = 0; i < ids.size(); ++i) {
+		if (keep[i])
+			simplified.push_back(ids[i]);
+	}
+	return simplified;
+}
+
+Diff RouteSimplifier::simplify(unsigned threadCount) const {
+	std::vector<const Route *> routes;
+	for (const auto &route : _network.routes() | std::views::values)
+		routes.push_back(&route);
+
+	std::vector<std::optional<std::vector<uint32_t>>> simplified(routes.size());
+	std::atomic<size_t> next = 0;
+	{
+		std::vector<std::jthread> threads;
+		for (unsigned i = 0; i < std::max(1u, threadCount); ++i) {
+			threads.emplace_back([&] {
+				for (auto n = next++; n < routes.size(); n = next++) {
+					if (routes[n]->anchors().size() < 3)
+						continue;
+					auto anchors = simplifyRoute(*routes[n]);
+					if (anchors.size() != routes[n]->anchors().size())
+						simplified[n] = std::move(anchors);
+				}
+			});
+		}
+	}
+
+	Diff diff;
+	std::unordered_set<uint32_t> removed;
+	std::unordered_set<uint32_t> used;
+	for (size_t n = 0; n < routes.size(); ++n) {
+		const auto &route = *routes[n];
+		if (!simplified[n]) {
+			used.insert(route.anchors().begin(), route.anchors().end());
+			continue;
+		}
+
+		removed.insert(route.anchors().begin(), route.anchors().end());
+		used.insert(simplified[n]->begin(), simplified[n]->end());
+
+		Route simplifiedRoute = route;
+		simplifiedRoute.anchors(std::move(*simplified[n]));
+		diff.routeChanges.edits.emplace(route.id(), std::pair(route, std::move(simplifiedRoute)));
+	}
+
+	// Sub-anchors shared with another route have to stay for that one
+	for (const auto id : removed) {
+		if (used.contains(id))
+			continue;
+		const auto &anchor = _network.anchors().at(id);
+		diff.anchorChanges.deletions.emplace(id, anchor);
+	}
+
+	return diff;
+}
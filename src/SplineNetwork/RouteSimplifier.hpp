@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Diff.hpp"
+#include "SplineNetwork.hpp"
+
+/// Removes sub-anchors that don't move their route by more than a tolerance, using Ramer-Douglas-Peucker
+/// Hub anchors, and the first and last anchor of every route, are always kept
+class RouteSimplifier {
+	const SplineNetwork &_network;
+	float _tolerance;
+
+	[[nodiscard]] std::vector<uint32_t> simplifyRoute(const Route &route) const;
+
+public:
+	/// `tolerance` is the furthest a removed anchor may be from the simplified route, in provinces.png pixels
+	RouteSimplifier(const SplineNetwork &network, float tolerance);
+
+	/// The route edits for every route that got simplified,
+	/// and deletions for the sub-anchors that are no longer used by any route
+	[[nodiscard]] Diff simplify(unsigned threadCount) const;
+};
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+// Only defined within this header, everything else checks simd::hasSse2 or uses FloatN
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SIMD_FLOAT_SSE2
+#endif
+
+/// Batches of floats for kernels over contiguous arrays, written once as templates over the batch type
+namespace simd {
+#ifdef SIMD_FLOAT_SSE2
+	constexpr bool hasSse2 = true;
+#else
+	constexpr bool hasSse2 = false;
+#endif
+
+	/// One float at a time, for the end of the arrays and machines without SSE2
+	struct Float1 {
+		static constexpr size_t width = 1;
+		float v;
+
+		static Float1 load(const float *p) { return {*p}; }
+		static Float1 broadcast(float f) { return {f}; }
+		void store(float *p) const { *p = v; }
+
+		friend Float1 operator+(Float1 a, Float1 b) { return {a.v + b.v}; }
+		friend Float1 operator-(Float1 a, Float1 b) { return {a.v - b.v}; }
+		friend Float1 operator*(Float1 a, Float1 b) { return {a.v * b.v}; }
+		friend Float1 sqrt(Float1 a) { return {std::sqrt(a.v)}; }
+		friend Float1 min(Float1 a, Float1 b) { return {std::min(a.v, b.v)}; }
+		friend Float1 max(Float1 a, Float1 b) { return {std::max(a.v, b.v)}; }
+	};
+#ifdef SIMD_FLOAT_SSE2
+	struct Float4 {
+		static constexpr size_t width = 4;
+		__m128 v;
+
+		static Float4 load(const float *p) { return {_mm_loadu_ps(p)}; }
+		static Float4 broadcast(float f) { return {_mm_set1_ps(f)}; }
+		void store(float *p) const { _mm_storeu_ps(p, v); }
+
+		friend Float4 operator+(Float4 a, Float4 b) { return {_mm_add_ps(a.v, b.v)}; }
+		friend Float4 operator-(Float4 a, Float4 b) { return {_mm_sub_ps(a.v, b.v)}; }
+		friend Float4 operator*(Float4 a, Float4 b) { return {_mm_mul_ps(a.v, b.v)}; }
+		friend Float4 sqrt(Float4 a) { return {_mm_sqrt_ps(a.v)}; }
+		friend Float4 min(Float4 a, Float4 b) { return {_mm_min_ps(a.v, b.v)}; }
+		friend Float4 max(Float4 a, Float4 b) { return {_mm_max_ps(a.v, b.v)}; }
+	};
+	/// The widest batch the target supports
+	using FloatN = Float4;
+#else
+	using FloatN = Float1;
+#endif
+} // namespace simd
+
+#undef SIMD_FLOAT_SSE2
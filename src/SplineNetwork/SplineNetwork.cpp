@@ -8,18 +8,27 @@
 #include "FileHandler/SplnetFileReader.hpp"
 #include "FileHandler/SplnetFileWriter.hpp"
 
-SplineNetwork::SplineNetwork(const std::filesystem::path &path) {
+SplineNetwork::SplineNetwork(const std::filesystem::path &path, SplnetIndex *index) {
 	fmt::print("Reading \"{}\"\n", path.string());
 
 	SplnetFileReader fileReader(path);
+	parse(fileReader, index);
 
+	if (index)
+		index->finalize(path);
+}
+SplineNetwork::SplineNetwork(std::span<const char> data, SplnetIndex *index) {
+	SplnetFileReader fileReader(data);
+	parse(fileReader, index);
+}
+void SplineNetwork::parse(SplnetFileReader &fileReader, SplnetIndex *index) {
 	auto [anchorCount, routeCount, stripCount] = parseFileHeader(fileReader);
 	if (anchorCount)
-		parseAnchorList(fileReader, anchorCount);
+		parseAnchorList(fileReader, anchorCount, index);
 	if (routeCount)
-		parseRouteList(fileReader, routeCount);
+		parseRouteList(fileReader, routeCount, index);
 	if (stripCount)
-		parseStripList(fileReader, stripCount);
+		parseStripList(fileReader, stripCount, index);
 }
 std::tuple<uint32_t, uint32_t, uint32_t> SplineNetwork::parseFileHeader(SplnetFileReader &fileReader) {
 	fileReader.expect<uint16_t>(0x00ee);
@@ -40,34 +49,61 @@ std::tuple<uint32_t, uint32_t, uint32_t> SplineNetwork::parseFileHeader(SplnetFi
 
 	return {anchorCount, routeCount, stripCount};
 }
-void SplineNetwork::parseAnchorList(SplnetFileReader &fileReader, uint32_t count) {
+void SplineNetwork::parseAnchorList(SplnetFileReader &fileReader, uint32_t count, SplnetIndex *index) {
 	fileReader.expectSectionHeader(0x05f4);
 
 	for (uint32_t i = 0; i < count; ++i) {
+		const auto offset = static_cast<uint32_t>(fileReader.position());
 		Anchor anchor(fileReader, i == count - 1);
+		if (index)
+			index->addAnchor(anchor.id(), offset);
 		_anchors.emplace(anchor.id(), anchor);
 	}
 }
-void SplineNetwork::parseRouteList(SplnetFileReader &fileReader, uint32_t count) {
+void SplineNetwork::parseRouteList(SplnetFileReader &fileReader, uint32_t count, SplnetIndex *index) {
 	fileReader.expectSectionHeader(0x05f5);
 
 	for (uint32_t i = 0; i < count; ++i) {
+		const auto offset = static_cast<uint32_t>(fileReader.position());
 		Route route(fileReader, i == count - 1);
+		if (index)
+			index->addRoute(route.id(), offset);
 		_routes.emplace(route.id(), std::move(route));
 	}
 }
-void SplineNetwork::parseStripList(SplnetFileReader &fileReader, uint32_t count) {
+void SplineNetwork::parseStripList(SplnetFileReader &fileReader, uint32_t count, SplnetIndex *index) {
 	fileReader.expectSectionHeader(0x05f6);
 
 	for (uint32_t i = 0; i < count; ++i) {
+		const auto offset = static_cast<uint32_t>(fileReader.position());
 		Strip strip(fileReader, i == count - 1);
+		if (index)
+			index->addStrip(strip.idPair(), offset);
 		_strips.emplace(strip.idPair(), strip);
 	}
 }
 
-void SplineNetwork::writeToFile(const std::filesystem::path &path) const {
-	SplnetFileWriter fileWriter(path);
+void SplineNetwork::writeToFile(const std::filesystem::path &path, bool writeIndex) const {
+	const auto indexPath = SplnetIndex::sidecarPath(path);
+	writeIndex |= std::filesystem::exists(indexPath);
 
+	SplnetIndex index;
+	SplnetFileWriter fileWriter;
+	writeRecords(fileWriter, writeIndex ? &index : nullptr);
+	fileWriter.save(path);
+
+	// The file needs to be written before it can be stamped into the index
+	if (writeIndex) {
+		index.finalize(path);
+		index.writeToFile(indexPath);
+	}
+}
+std::vector<char> SplineNetwork::toBytes() const {
+	SplnetFileWriter fileWriter;
+	writeRecords(fileWriter, nullptr);
+	return fileWriter.takeBuffer();
+}
+void SplineNetwork::writeRecords(SplnetFileWriter &fileWriter, SplnetIndex *index) const {
 	fileWriter.write<uint16_t>(0x00ee);
 	fileWriter.write<uint16_t>(0x0001);
 	fileWriter.write<uint16_t>(0x000c);
@@ -86,16 +122,22 @@ void SplineNetwork::writeToFile(const std::filesystem::path &path) const {
 
 	fileWriter.writeSectionHeader(0x05f4);
 	for (auto it = _anchors.cbegin(); it != _anchors.cend(); ++it) {
+		if (index)
+			index->addAnchor(it->first, static_cast<uint32_t>(fileWriter.position()));
 		it->second.writeToFile(fileWriter, it == std::prev(_anchors.cend()));
 	}
 
 	fileWriter.writeSectionHeader(0x05f5);
 	for (auto it = _routes.cbegin(); it != _routes.cend(); ++it) {
+		if (index)
+			index->addRoute(it->first, static_cast<uint32_t>(fileWriter.position()));
 		it->second.writeToFile(fileWriter, it == std::prev(_routes.cend()));
 	}
 
 	fileWriter.writeSectionHeader(0x05f6);
 	for (auto it = _strips.cbegin(); it != _strips.cend(); ++it) {
+		if (index)
+			index->addStrip(it->first, static_cast<uint32_t>(fileWriter.position()));
 		it->second.writeToFile(fileWriter, it == std::prev(_strips.cend()));
 	}
 }
@@ -111,17 +153,32 @@ Diff SplineNetwork::calculateDiff(const SplineNetwork &other) const {
 }
 
 void SplineNetwork::applyDiff(Diff diff) {
-	std::set<uint32_t> reservedAnchorIds;
-	std::set<uint32_t> reservedRouteIds;
-	for (const auto &id : _anchors | std::views::keys) {
-		reservedAnchorIds.emplace(id);
-	}
-	for (const auto &id : _routes | std::views::keys) {
-		reservedRouteIds.emplace(id);
-	}
+	// Looked up in the network directly, copying every id would cost more than the rest of a small diff
+	ReservedIds reservedAnchorIds([this](uint32_t id) { return _anchors.contains(id); });
+	ReservedIds reservedRouteIds([this](uint32_t id) { return _routes.contains(id); });
 	diff.remapCollisions(reservedAnchorIds, reservedRouteIds);
 
-	applyChangeList(_anchors, diff.anchorChanges);
-	applyChangeList(_strips, diff.stripChanges);
-	applyChangeList(_routes, diff.routeChanges);
+	applyCombinedDiff(diff);
+}
+void SplineNetwork::applyDiffs(std::vector<Diff> diffs, ConflictPolicy policy) {
+	ReservedIds reservedAnchorIds([this](uint32_t id) { return _anchors.contains(id); });
+	ReservedIds reservedRouteIds([this](uint32_t id) { return _routes.contains(id); });
+
+	applyCombinedDiff(Diff::combine(std::move(diffs), reservedAnchorIds, reservedRouteIds, policy));
+}
+void SplineNetwork::applyCombinedDiff(const Diff &diff) {
+	UndoJournal journal;
+	try {
+		applyChangeList(_anchors, diff.anchorChanges, journal.anchors);
+		applyChangeList(_strips, diff.stripChanges, journal.strips);
+		applyChangeList(_routes, diff.routeChanges, journal.routes);
+	} catch (...) {
+		revert(journal);
+		throw;
+	}
+}
+void SplineNetwork::revert(UndoJournal &journal) {
+	revertChangeList(_routes, journal.routes);
+	revertChangeList(_strips, journal.strips);
+	revertChangeList(_anchors, journal.anchors);
 }
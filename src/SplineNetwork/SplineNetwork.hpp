@@ -2,6 +2,8 @@
 
 #include "Anchor.hpp"
 #include "Diff.hpp"
+#include "FileHandler/SplnetIndex.hpp"
+#include "PersistentMap.hpp"
 #include "Route.hpp"
 #include "Strip.hpp"
 
@@ -9,34 +11,78 @@
 #include <filesystem>
 #include <iostream>
 #include <map>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <vector>
 
 #include <fmt/ostream.h>
 
+/// Copies are cheap, sharing everything with the original until either is changed
 class SplineNetwork {
-	std::map<uint32_t, Anchor> _anchors;
-	std::map<uint32_t, Route> _routes;
-	std::map<std::pair<uint32_t, uint32_t>, Strip> _strips;
+public:
+	using AnchorMap = PersistentMap<uint32_t, Anchor>;
+	using RouteMap = PersistentMap<uint32_t, Route>;
+	using StripMap = PersistentMap<std::pair<uint32_t, uint32_t>, Strip>;
+
+private:
+	/// What applying a diff changed, in order, with the version each item had before or none if it was inserted
+	/// Costs as much as the diff, rather than a copy of the network
+	struct UndoJournal {
+		template <typename K, typename T> using Entries = std::vector<std::pair<K, std::optional<T>>>;
+
+		Entries<uint32_t, Anchor> anchors;
+		Entries<std::pair<uint32_t, uint32_t>, Strip> strips;
+		Entries<uint32_t, Route> routes;
+	};
 
+	AnchorMap _anchors;
+	RouteMap _routes;
+	StripMap _strips;
+
+	void parse(SplnetFileReader &fileReader, SplnetIndex *index);
 	static std::tuple<uint32_t, uint32_t, uint32_t> parseFileHeader(SplnetFileReader &fileReader);
-	void parseAnchorList(SplnetFileReader &fileReader, uint32_t count);
-	void parseRouteList(SplnetFileReader &fileReader, uint32_t count);
-	void parseStripList(SplnetFileReader &fileReader, uint32_t count);
+	void parseAnchorList(SplnetFileReader &fileReader, uint32_t count, SplnetIndex *index);
+	void parseRouteList(SplnetFileReader &fileReader, uint32_t count, SplnetIndex *index);
+	void parseStripList(SplnetFileReader &fileReader, uint32_t count, SplnetIndex *index);
+	void writeRecords(SplnetFileWriter &fileWriter, SplnetIndex *index) const;
+
+	/// Apply the changes, rolling back the ones already made if anything throws partway through
+	void applyCombinedDiff(const Diff &diff);
+	/// Undo the changes recorded in `journal`
+	void revert(UndoJournal &journal);
 
 public:
 	SplineNetwork() = default;
-	explicit SplineNetwork(const std::filesystem::path &path);
+	/// If `index` is provided the offsets of every record get recorded into it
+	explicit SplineNetwork(const std::filesystem::path &path, SplnetIndex *index = nullptr);
+	/// Parse a network file that is already in memory
+	explicit SplineNetwork(std::span<const char> data, SplnetIndex *index = nullptr);
 
-	void writeToFile(const std::filesystem::path &path) const;
+	/// Writes a .splidx sidecar if `writeIndex` is set, an already existing sidecar is always kept up to date
+	void writeToFile(const std::filesystem::path &path, bool writeIndex = false) const;
+	/// The exact bytes writeToFile would write
+	[[nodiscard]] std::vector<char> toBytes() const;
+
+	[[nodiscard]] const auto &anchors() const { return _anchors; }
+	[[nodiscard]] const auto &routes() const { return _routes; }
+	[[nodiscard]] const auto &strips() const { return _strips; }
 
 	/// Calculate the changes to, other
 	/// Usually called on the vanilla network with `other` being the modded network
 	[[nodiscard]] Diff calculateDiff(const SplineNetwork &other) const;
 	/// Apply the changes to this network
+	/// If anything throws partway through, the changes already made are rolled back before rethrowing
 	/// Usually called on the vanilla network
 	void applyDiff(Diff diff);
+	/// Apply several diffs made against this network at once, throws if any of them conflict in a way `policy`
+	/// doesn't resolve. Rolled back the same way as applyDiff
+	void applyDiffs(std::vector<Diff> diffs, ConflictPolicy policy = ConflictPolicy::Fail);
 
+	/// Records every item it changes in `journal` before changing it
 	template <typename K, typename T>
-	void applyChangeList(std::map<K, T> &items, const NetworkItemChanges<K, T> &changes) {
+	static void applyChangeList(PersistentMap<K, T> &items, const NetworkItemChanges<K, T> &changes,
+	                            std::vector<std::pair<K, std::optional<T>>> &journal) {
 		for (const auto &[id, versionPair] : changes.edits) {
 			const auto &[oldVersion, newVersion] = versionPair;
 			auto it = items.find(id);
@@ -55,7 +101,8 @@ public:
 					           oldVersion);
 				}
 			}
-			items[id] = newVersion;
+			journal.emplace_back(id, it == items.end() ? std::nullopt : std::optional(it->second));
+			items.insert_or_assign(id, newVersion);
 		}
 
 		for (const auto &[id, deletedItem] : changes.deletions) {
@@ -75,6 +122,7 @@ public:
 				           "careful.\n",
 				           deletedItem);
 			}
+			journal.emplace_back(id, it->second);
 			items.erase(it);
 		}
 		for (const auto &[id, newItem] : changes.additions) {
@@ -86,8 +134,21 @@ public:
 				           newItem);
 				throw std::runtime_error("Attempting to insert item with existing id, aborting to maintain coherence.");
 			}
-			items[id] = newItem;
+			journal.emplace_back(id, std::nullopt);
+			items.insert_or_assign(id, newItem);
+		}
+	}
+
+	/// Put the items in `journal` back the way they were, latest change first
+	template <typename K, typename T>
+	static void revertChangeList(PersistentMap<K, T> &items, std::vector<std::pair<K, std::optional<T>>> &journal) {
+		for (auto &[id, previousVersion] : journal | std::views::reverse) {
+			if (previousVersion)
+				items.insert_or_assign(id, std::move(*previousVersion));
+			else
+				items.erase(id);
 		}
+		journal.clear();
 	}
 
 	NLOHMANN_DEFINE_TYPE_INTRUSIVE(SplineNetwork, _anchors, _routes, _strips);
@@ -43,3 +43,20 @@ void Strip::remapRoutes(const std::map<uint32_t, uint32_t> &map) {
 			routeID = map.at(routeID);
 	}
 }
+
+std::string_view Strip::typeName(Type type) {
+	switch (type) {
+	case Type::DIRT_ROAD:       return "dirt-road";
+	case Type::RAILROAD:        return "railroad";
+	case Type::SEA_CONNECTION:  return "sea";
+	case Type::PORT_CONNECTION: return "port";
+	}
+	return "unknown";
+}
+std::optional<Strip::Type> Strip::parseType(std::string_view name) {
+	for (const auto type : {Type::DIRT_ROAD, Type::RAILROAD, Type::SEA_CONNECTION, Type::PORT_CONNECTION}) {
+		if (name == typeName(type))
+			return type;
+	}
+	return std::nullopt;
+}
@@ -3,6 +3,8 @@
 #include "FileHandler/SplnetFileReader.hpp"
 #include "FileHandler/SplnetFileWriter.hpp"
 
+#include <optional>
+#include <string_view>
 #include <vector>
 
 #include <nlohmann/json.hpp>
@@ -38,6 +40,9 @@ public:
 	void writeToFile(SplnetFileWriter &fileWriter, bool isFinal = false) const;
 
 	[[nodiscard]] auto type() const { return (Type)(_sourceID & ((1 << 6) - 1)); }
+	/// The names used for types on the command line
+	static std::string_view typeName(Type type);
+	static std::optional<Type> parseType(std::string_view name);
 
 	[[nodiscard]] auto sourceID() const { return _sourceID >> 6; }
 	void sourceID(uint32_t set) { _sourceID = (uint32_t)type() | (set << 6); }
@@ -47,6 +52,9 @@ public:
 	[[nodiscard]] auto rawSourceID() const { return _sourceID; }
 	[[nodiscard]] auto rawDestinationID() const { return _destinationID; }
 
+	[[nodiscard]] const auto &routeIDs() const { return _routeIDs; }
+	void routeIDs(std::vector<uint64_t> set) { _routeIDs = std::move(set); }
+
 	/// Id pair, used as std::map id, since it maps cleanly onto the sorting order used in the files
 	[[nodiscard]] std::pair<uint32_t, uint32_t> idPair() const { return {rawDestinationID(), rawSourceID()}; }
 
@@ -1,13 +1,32 @@
+#include <algorithm>
+#include <atomic>
+#include <cmath>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <numeric>
+#include <set>
+#include <span>
 #include <string_view>
+#include <thread>
 #include <vector>
 
 #include <argparse/argparse.hpp>
 #include <nlohmann/json.hpp>
 
+#include "Image/Image.hpp"
+#include "Provinces/ProvinceMap.hpp"
+#include "Render/NetworkRenderer.hpp"
+#include "Server/NetworkServer.hpp"
+#include "SplineNetwork/AnchorTransform.hpp"
 #include "SplineNetwork/Diff.hpp"
+#include "SplineNetwork/FileHandler/MappedFile.hpp"
+#include "SplineNetwork/FileHandler/SplnetIndex.hpp"
+#include "SplineNetwork/NetworkArchive.hpp"
+#include "SplineNetwork/NetworkGraph.hpp"
+#include "SplineNetwork/RouteDeduplicator.hpp"
+#include "SplineNetwork/RouteMetrics.hpp"
+#include "SplineNetwork/RouteSimplifier.hpp"
 #include "SplineNetwork/SplineNetwork.hpp"
 #include "util.hpp"
 #include "version.hpp"
@@ -15,17 +34,75 @@
 namespace fs = std::filesystem;
 using json = nlohmann::json;
 
+/// The policy picked with --on-conflict
+ConflictPolicy conflictPolicy(const argparse::ArgumentParser &arguments) {
+	const auto policy = arguments.get("--on-conflict");
+	return policy == "prefer-deletions" ? ConflictPolicy::PreferDeletions
+	       : policy == "prefer-first"   ? ConflictPolicy::PreferFirst
+	       : policy == "prefer-last"    ? ConflictPolicy::PreferLast
+	                                    : ConflictPolicy::Fail;
+}
+/// Merge the changes every network makes compared to `base` into it, exits if they conflict and the policy is to fail
+void mergeNetworks(SplineNetwork &base, std::span<const fs::path> networkPaths,
+                   const argparse::ArgumentParser &arguments) {
+	const MergeOptions options{
+	    .policy = conflictPolicy(arguments),
+	    .weldTolerance = arguments.present<float>("--weld"),
+	    .deduplicate = arguments.get<bool>("--dedup"),
+	};
+	const auto reportPath = arguments.present("--conflict-report");
+
+	Diff mergedDiff;
+	MergeReport report;
+	bool failed = false;
+	for (const auto &path : networkPaths) {
+		SplineNetwork toMerge(path);
+		try {
+			mergedDiff.mergeDiff(base.calculateDiff(toMerge), options, &report);
+		} catch (const std::runtime_error &err) {
+			fmt::print(std::cerr, "{}: {}\n", path.string(), err.what());
+			failed = true;
+		}
+	}
+
+	if (report.identical || report.compatible || report.deletedEdits || !report.conflicts.empty()) {
+		fmt::print("{} items changed identically, {} compatibly, {} deleted over edits, and {} in conflicting ways.\n",
+		           report.identical, report.compatible, report.deletedEdits, report.conflicts.size());
+	}
+	if (reportPath) {
+		json jsonFile = report;
+		std::ofstream outputFile(*reportPath);
+		outputFile << jsonFile.dump(4) << '\n';
+	}
+	if (failed)
+		std::exit(1);
+
+	base.applyDiff(std::move(mergedDiff));
+}
 void handleApply(const argparse::ArgumentParser &arguments) {
 	const fs::path baseNetworkPath = arguments.get("BaseNetwork");
-	const fs::path diffPath = arguments.get("DiffFile");
+	const auto diffFilesStr = arguments.get<std::vector<std::string>>("DiffFiles");
+	const std::vector<fs::path> diffPaths(diffFilesStr.begin(), diffFilesStr.end());
 	const fs::path outputPath = arguments.is_used("-o") ? fs::path(arguments.get("-o")) : baseNetworkPath;
 
-	if (!checkFilesExist(baseNetworkPath, diffPath)) {
+	if (!checkFileExists(baseNetworkPath)) {
+		std::exit(1);
+	}
+	if (!checkFilesExist(diffPaths)) {
 		std::exit(1);
 	}
 
+	std::vector<Diff> diffs;
+	for (const auto &path : diffPaths)
+		diffs.push_back(json::parse(std::ifstream(path)).get<Diff>());
+
 	SplineNetwork network(baseNetworkPath);
-	network.applyDiff(json::parse(std::ifstream(diffPath)).get<Diff>());
+	try {
+		network.applyDiffs(std::move(diffs), conflictPolicy(arguments));
+	} catch (const std::runtime_error &err) {
+		fmt::print(std::cerr, "{}\n", err.what());
+		std::exit(1);
+	}
 	network.writeToFile(outputPath);
 }
 void handleGenerate(const argparse::ArgumentParser &arguments) {
@@ -44,6 +121,43 @@ void handleGenerate(const argparse::ArgumentParser &arguments) {
 	std::ofstream outputFile(outputPath);
 	outputFile << jsonFile.dump(4) << '\n';
 }
+void handleCompose(const argparse::ArgumentParser &arguments) {
+	const auto diffFilesStr = arguments.get<std::vector<std::string>>("DiffFiles");
+	const std::vector<fs::path> diffPaths(diffFilesStr.begin(), diffFilesStr.end());
+	const fs::path outputPath = arguments.get("-o");
+
+	if (!checkFilesExist(diffPaths)) {
+		std::exit(1);
+	}
+
+	auto composed = json::parse(std::ifstream(diffPaths.front())).get<Diff>();
+	try {
+		for (const auto &path : diffPaths | std::views::drop(1))
+			composed = Diff::compose(std::move(composed), json::parse(std::ifstream(path)).get<Diff>());
+	} catch (const std::runtime_error &err) {
+		fmt::print(std::cerr, "{}\n", err.what());
+		std::exit(1);
+	}
+
+	json jsonFile = composed;
+	std::ofstream outputFile(outputPath);
+	outputFile << jsonFile.dump(4) << '\n';
+}
+void handleInvert(const argparse::ArgumentParser &arguments) {
+	const fs::path diffPath = arguments.get("DiffFile");
+	const fs::path outputPath = arguments.get("-o");
+
+	if (!checkFileExists(diffPath)) {
+		std::exit(1);
+	}
+
+	auto diff = json::parse(std::ifstream(diffPath)).get<Diff>();
+	diff.invert();
+
+	json jsonFile = diff;
+	std::ofstream outputFile(outputPath);
+	outputFile << jsonFile.dump(4) << '\n';
+}
 void handleFullMerge(const argparse::ArgumentParser &arguments) {
 	const auto networkFilesStr = arguments.get<std::vector<std::string>>("Networks");
 	const std::vector<fs::path> networkPaths(networkFilesStr.begin(), networkFilesStr.end());
@@ -54,13 +168,7 @@ void handleFullMerge(const argparse::ArgumentParser &arguments) {
 	}
 
 	SplineNetwork emptyNetwork;
-	Diff mergedDiff;
-	for (const auto &path : networkPaths) {
-		SplineNetwork toMerge(path);
-		mergedDiff.mergeDiff(emptyNetwork.calculateDiff(toMerge));
-	}
-
-	emptyNetwork.applyDiff(mergedDiff);
+	mergeNetworks(emptyNetwork, networkPaths, arguments);
 	emptyNetwork.writeToFile(outputPath);
 }
 void handleMerge(const argparse::ArgumentParser &arguments) {
@@ -77,14 +185,59 @@ void handleMerge(const argparse::ArgumentParser &arguments) {
 	}
 
 	SplineNetwork baseNetwork(basePath);
-	Diff mergedDiff;
-	for (const auto &path : networkPaths) {
-		SplineNetwork toMerge(path);
-		mergedDiff.mergeDiff(baseNetwork.calculateDiff(toMerge));
+	mergeNetworks(baseNetwork, networkPaths, arguments);
+	baseNetwork.writeToFile(outputPath);
+}
+void handleMergeDriver(const argparse::ArgumentParser &arguments) {
+	const fs::path ancestorPath = arguments.get("Ancestor");
+	const fs::path currentPath = arguments.get("Current");
+	const fs::path otherPath = arguments.get("Other");
+
+	if (!checkFilesExist(ancestorPath, currentPath, otherPath)) {
+		std::exit(1);
 	}
 
-	baseNetwork.applyDiff(mergedDiff);
-	baseNetwork.writeToFile(outputPath);
+	std::vector<char> merged;
+	{
+		const MappedFile ancestorFile(ancestorPath);
+		const MappedFile currentFile(currentPath);
+		const MappedFile otherFile(otherPath);
+		const auto ancestor = ancestorFile.data();
+		const auto current = currentFile.data();
+		const auto other = otherFile.data();
+
+		// If only one side changed anything there is nothing to parse, the result is just that side
+		if (std::ranges::equal(other, ancestor) || std::ranges::equal(other, current))
+			return;
+		if (std::ranges::equal(current, ancestor)) {
+			merged.assign(other.begin(), other.end());
+		} else {
+			// Git passes an empty ancestor when both sides added the file
+			const auto parse = [](std::span<const char> data) {
+				return data.empty() ? SplineNetwork() : SplineNetwork(data);
+			};
+
+			SplineNetwork baseNetwork = parse(ancestor);
+			Diff mergedDiff = baseNetwork.calculateDiff(parse(current));
+			try {
+				const MergeOptions options{
+				    .policy = conflictPolicy(arguments),
+				    .weldTolerance = std::nullopt,
+				    .deduplicate = false,
+				};
+				mergedDiff.mergeDiff(baseNetwork.calculateDiff(parse(other)), options);
+				baseNetwork.applyDiff(std::move(mergedDiff));
+			} catch (const std::runtime_error &err) {
+				// Leave the current version in place, git will mark the file as conflicted
+				fmt::print(std::cerr, "{}\n", err.what());
+				std::exit(1);
+			}
+			merged = baseNetwork.toBytes();
+		}
+	}
+
+	std::ofstream outputFile(currentPath, std::ios::out | std::ios::binary | std::ios::trunc);
+	outputFile.write(merged.data(), static_cast<std::streamsize>(merged.size()));
 }
 void handleExport(const argparse::ArgumentParser &arguments) {
 	const fs::path networkPath = arguments.get("NetworkFile");
@@ -104,6 +257,643 @@ void handleImport(const argparse::ArgumentParser &arguments) {
 	auto network = json::parse(inputFile).get<SplineNetwork>();
 	network.writeToFile(outputPath);
 }
+/// Decode the single record at the offset from the index
+template <typename T> T decodeRecord(const MappedFile &networkFile, const SplnetIndex::Record &record) {
+	SplnetFileReader fileReader(networkFile.data(), record.offset);
+	return T(fileReader, record.isFinal);
+}
+
+void handleIndex(const argparse::ArgumentParser &arguments) {
+	const fs::path networkPath = arguments.get("NetworkFile");
+
+	if (!checkFileExists(networkPath)) {
+		std::exit(1);
+	}
+
+	SplnetIndex index;
+	SplineNetwork network(networkPath, &index);
+	index.writeToFile(SplnetIndex::sidecarPath(networkPath));
+}
+void handleShow(const argparse::ArgumentParser &arguments) {
+	const fs::path networkPath = arguments.get("NetworkFile");
+	const auto indexPath = SplnetIndex::sidecarPath(networkPath);
+	const auto anchorIDs = arguments.get<std::vector<uint32_t>>("--anchor");
+	const auto routeIDs = arguments.get<std::vector<uint32_t>>("--route");
+	const auto stripIDs = arguments.get<std::vector<uint32_t>>("--strip");
+
+	if (!checkFileExists(networkPath)) {
+		std::exit(1);
+	}
+	if (!exists(indexPath)) {
+		fmt::print(std::cerr, "{}: No index found, create one with the 'index' command.\n", indexPath.string());
+		std::exit(1);
+	}
+	if (stripIDs.size() % 2 != 0) {
+		fmt::print(std::cerr, "--strip takes pairs of source and destination IDs.\n");
+		std::exit(1);
+	}
+
+	const SplnetIndex index(indexPath);
+	if (index.isStale(networkPath)) {
+		fmt::print(std::cerr, "{}: Index is out of date, recreate it with the 'index' command.\n", indexPath.string());
+		std::exit(1);
+	}
+
+	const MappedFile networkFile(networkPath);
+	// The index is only a hint, double-check that the decoded record is the one asked for
+	auto checkID = [](const auto &item, auto expected, auto actual, const SplnetIndex::Record &record) {
+		if (expected != actual) {
+			throw std::runtime_error(fmt::format("{} found at {:#x}, index is out of date.", item, record.offset));
+		}
+	};
+
+	json output;
+	output["anchors"] = json::array();
+	output["routes"] = json::array();
+	output["strips"] = json::array();
+
+	for (const auto id : anchorIDs) {
+		const auto record = index.findAnchor(id);
+		if (!record) {
+			fmt::print(std::cerr, "Anchor {:#x} not found.\n", id);
+			continue;
+		}
+		const auto anchor = decodeRecord<Anchor>(networkFile, *record);
+		checkID(anchor, id, anchor.id(), *record);
+		output["anchors"].push_back(anchor);
+	}
+	for (const auto id : routeIDs) {
+		const auto record = index.findRoute(id);
+		if (!record) {
+			fmt::print(std::cerr, "Route {:#x} not found.\n", id);
+			continue;
+		}
+		const auto route = decodeRecord<Route>(networkFile, *record);
+		checkID(route, id, route.id(), *record);
+		output["routes"].push_back(route);
+	}
+	for (size_t i = 0; i < stripIDs.size(); i += 2) {
+		const auto ids = std::pair(stripIDs[i], stripIDs[i + 1]);
+		const auto records = index.findStrips(ids.first, ids.second);
+		if (records.empty()) {
+			fmt::print(std::cerr, "Strip {}->{} not found.\n", ids.first, ids.second);
+			continue;
+		}
+		for (const auto &record : records) {
+			const auto strip = decodeRecord<Strip>(networkFile, record);
+			checkID(strip, ids, std::pair(strip.sourceID(), strip.destinationID()), record);
+			output["strips"].push_back(strip);
+		}
+	}
+
+	std::cout << output.dump(4) << '\n';
+}
+void handleRender(const argparse::ArgumentParser &arguments) {
+	const fs::path networkPath = arguments.get("NetworkFile");
+	const fs::path outputPath = arguments.get("-o");
+	const auto provincesPath = arguments.present("--provinces");
+	const auto diffBasePath = arguments.present("--diff");
+	const auto size = arguments.get<std::vector<uint32_t>>("--size");
+	const auto threadCount = arguments.get<unsigned>("--threads");
+
+	if (!checkFileExists(networkPath)) {
+		std::exit(1);
+	}
+	if ((provincesPath && !checkFileExists(*provincesPath)) || (diffBasePath && !checkFileExists(*diffBasePath))) {
+		std::exit(1);
+	}
+
+	// The provinces are drawn darkened underneath the network, to give some sense of place
+	Image image;
+	if (provincesPath) {
+		image = Image::readPng(*provincesPath);
+		for (uint32_t y = 0; y < image.height(); ++y) {
+			for (uint32_t x = 0; x < image.width(); ++x) {
+				const auto [r, g, b] = image.pixel(x, y);
+				image.pixel(x, y,
+				            {static_cast<uint8_t>(r / 3), static_cast<uint8_t>(g / 3), static_cast<uint8_t>(b / 3)});
+			}
+		}
+	} else {
+		image = Image(size.at(0), size.at(1), {24, 24, 24});
+	}
+
+	SplineNetwork network(networkPath);
+	NetworkRenderer renderer(image.width(), image.height());
+	if (diffBasePath) {
+		SplineNetwork baseNetwork{fs::path(*diffBasePath)};
+		renderer.addDiff(baseNetwork, network);
+	} else {
+		renderer.addNetwork(network);
+	}
+
+	renderer.render(image, threadCount);
+	image.writeToFile(outputPath);
+}
+void handleProvinces(const argparse::ArgumentParser &arguments) {
+	const fs::path provincesPath = arguments.get("ProvincesFile");
+	const fs::path networkPath = arguments.get("NetworkFile");
+	const fs::path outputPath = arguments.get("-o");
+	const auto defaultMapPath = arguments.present("--default-map");
+	const auto stateRegionsPath = arguments.present("--state-regions");
+
+	if (!checkFilesExist(provincesPath, networkPath)) {
+		std::exit(1);
+	}
+	if ((defaultMapPath && !checkFileExists(*defaultMapPath)) ||
+	    (stateRegionsPath && !checkFileExists(*stateRegionsPath))) {
+		std::exit(1);
+	}
+
+	ProvinceMap provinceMap(provincesPath);
+	if (defaultMapPath)
+		provinceMap.loadDefaultMap(*defaultMapPath);
+	if (stateRegionsPath)
+		provinceMap.loadStateRegions(*stateRegionsPath);
+
+	SplineNetwork network(networkPath);
+	const auto anchorProvinces = provinceMap.locateAnchors(network.anchors());
+
+	struct ProvinceCounts {
+		uint32_t hubAnchors = 0;
+		uint32_t subAnchors = 0;
+		uint32_t strips = 0;
+	};
+	std::map<uint32_t, ProvinceCounts> counts;
+	json issues = {{"outOfBounds", json::array()},
+	               {"landAnchorsOnWater", json::array()},
+	               {"waterAnchorsOnLand", json::array()},
+	               {"unmappedAnchors", json::array()}};
+
+	// Strips only know the IDs of their anchors
+	std::map<uint32_t, std::optional<uint32_t>> hubProvinces;
+	auto anchorIt = network.anchors().begin();
+	for (const auto &province : anchorProvinces) {
+		const auto &[id, anchor] = *anchorIt++;
+		if (!anchor.isSubAnchor())
+			hubProvinces.emplace_hint(hubProvinces.end(), id, province);
+
+		if (!province) {
+			issues["outOfBounds"].push_back(id);
+			continue;
+		}
+
+		auto &count = counts[*province];
+		(anchor.isSubAnchor() ? count.subAnchors : count.hubAnchors)++;
+
+		if (provinceMap.isWater(*province) && !anchor.isWaterAnchor())
+			issues["landAnchorsOnWater"].push_back({{"anchor", id}, {"province", ProvinceMap::colourName(*province)}});
+		// Without default.map every province looks like land
+		if (anchor.isWaterAnchor() && !provinceMap.isWater(*province) && defaultMapPath)
+			issues["waterAnchorsOnLand"].push_back({{"anchor", id}, {"province", ProvinceMap::colourName(*province)}});
+		if (provinceMap.hasStates() && !provinceMap.isWater(*province) && !provinceMap.state(*province))
+			issues["unmappedAnchors"].push_back({{"anchor", id}, {"province", ProvinceMap::colourName(*province)}});
+	}
+
+	for (const auto &strip : network.strips() | std::views::values) {
+		auto source = hubProvinces.find(strip.sourceID());
+		auto destination = hubProvinces.find(strip.destinationID());
+		const auto sourceProvince = source != hubProvinces.end() ? source->second : std::nullopt;
+		const auto destinationProvince = destination != hubProvinces.end() ? destination->second : std::nullopt;
+
+		if (sourceProvince)
+			counts[*sourceProvince].strips++;
+		if (destinationProvince && destinationProvince != sourceProvince)
+			counts[*destinationProvince].strips++;
+	}
+
+	json report;
+	report["provinces"] = json::array();
+	for (const auto &[province, count] : counts) {
+		json entry = {{"province", ProvinceMap::colourName(province)},
+		              {"hubAnchors", count.hubAnchors},
+		              {"subAnchors", count.subAnchors},
+		              {"strips", count.strips}};
+		if (const auto state = provinceMap.state(province))
+			entry["state"] = *state;
+		report["provinces"].push_back(entry);
+	}
+	report.update(issues);
+
+	fmt::print("{} anchors in {} provinces\n", anchorProvinces.size(), counts.size());
+	for (const auto &[name, list] : issues.items()) {
+		if (!list.empty())
+			fmt::print(std::cerr, "{}: {}\n", name, list.size());
+	}
+
+	std::ofstream outputFile(outputPath);
+	outputFile << report.dump(4) << '\n';
+}
+/// Parse the --type arguments, exiting on unknown names
+std::vector<Strip::Type> parseStripTypes(const argparse::ArgumentParser &arguments) {
+	std::vector<Strip::Type> types;
+	for (const auto &name : arguments.get<std::vector<std::string>>("--type")) {
+		const auto type = Strip::parseType(name);
+		if (!type) {
+			fmt::print(std::cerr, "{}: Unknown strip type, expected dirt-road, railroad, sea, or port\n", name);
+			std::exit(1);
+		}
+		types.push_back(*type);
+	}
+	return types;
+}
+void handlePath(const argparse::ArgumentParser &arguments) {
+	const fs::path networkPath = arguments.get("NetworkFile");
+	const auto fromAnchor = arguments.get<uint32_t>("From");
+	const auto toAnchor = arguments.get<uint32_t>("To");
+	const auto types = parseStripTypes(arguments);
+
+	if (!checkFileExists(networkPath)) {
+		std::exit(1);
+	}
+
+	SplineNetwork network(networkPath);
+	const NetworkGraph graph(network, types);
+
+	for (const auto id : {fromAnchor, toAnchor}) {
+		auto it = network.anchors().find(id);
+		if (it == network.anchors().end() || it->second.isSubAnchor()) {
+			fmt::print(std::cerr, "{:#x}: Not a hub anchor in the network\n", id);
+			std::exit(1);
+		}
+	}
+
+	const auto path = graph.shortestPath(fromAnchor, toAnchor);
+	if (!path) {
+		fmt::print(std::cerr, "{} and {} are not connected\n", network.anchors().at(fromAnchor),
+		           network.anchors().at(toAnchor));
+		std::exit(1);
+	}
+
+	for (const auto &step : path->steps) {
+		fmt::print("{} -> {} ({}, {:.1f})\n", network.anchors().at(step.from), network.anchors().at(step.to),
+		           Strip::typeName(step.type), step.length);
+	}
+	fmt::print("Total length {:.1f} over {} strips\n", path->length, path->steps.size());
+}
+void handleComponents(const argparse::ArgumentParser &arguments) {
+	const fs::path networkPath = arguments.get("NetworkFile");
+	const auto outputPath = arguments.present("-o");
+	const auto types = parseStripTypes(arguments);
+
+	if (!checkFileExists(networkPath)) {
+		std::exit(1);
+	}
+
+	SplineNetwork network(networkPath);
+	const NetworkGraph graph(network, types);
+	const auto components = graph.components();
+
+	const auto isolated = std::ranges::count_if(components, [](const auto &c) { return c.size() == 1; });
+	fmt::print("{} hub anchors and {} strips in {} components, {} of them isolated anchors\n", graph.nodeCount(),
+	           graph.edgeCount(), components.size(), isolated);
+	for (const auto &component : components | std::views::take(10)) {
+		if (component.size() == 1)
+			break;
+		fmt::print("\t{} anchors, containing {}\n", component.size(), network.anchors().at(component.front()));
+	}
+
+	if (outputPath) {
+		json jsonFile = components;
+		std::ofstream outputFile(*outputPath);
+		outputFile << jsonFile.dump(4) << '\n';
+	}
+}
+/// A description of the record, and the offset just past its end
+template <typename T>
+std::pair<std::string, size_t> describeRecord(std::span<const char> data, const SplnetIndex::Record &record) {
+	SplnetFileReader fileReader(data, record.offset);
+	const T item(fileReader, record.isFinal);
+	return {fmt::format("{}", item), fileReader.position()};
+}
+/// Why the network doesn't come out byte-identical after being parsed and written again, nullopt if it does
+std::optional<std::string> verifyRoundTrip(const fs::path &networkPath) {
+	const MappedFile networkFile(networkPath);
+	const auto original = networkFile.data();
+
+	SplnetIndex index;
+	std::vector<char> written;
+	try {
+		written = SplineNetwork(original, &index).toBytes();
+	} catch (const std::runtime_error &err) {
+		return fmt::format("failed to parse: {}", err.what());
+	}
+
+	if (std::ranges::equal(written, original))
+		return std::nullopt;
+
+	const auto offset = static_cast<size_t>(std::ranges::mismatch(original, written).in1 - original.begin());
+	std::string where = "the file header";
+	index.finalize(networkPath);
+	if (const auto location = index.locate(offset)) {
+		using enum SplnetIndex::RecordType;
+		const auto [record, end] = location->type == Anchor ? describeRecord<::Anchor>(original, location->record)
+		                           : location->type == Route ? describeRecord<::Route>(original, location->record)
+		                                                     : describeRecord<::Strip>(original, location->record);
+		where = offset < end ? record : fmt::format("the section header after {}", record);
+	}
+
+	return fmt::format("differs at offset {:#x}, in {} (original is {} bytes, rewritten is {} bytes)", offset, where,
+	                   original.size(), written.size());
+}
+void handleVerify(const argparse::ArgumentParser &arguments) {
+	const auto pathsStr = arguments.get<std::vector<std::string>>("Paths");
+	const auto threadCount = arguments.get<unsigned>("--threads");
+
+	std::vector<fs::path> networkPaths;
+	for (const fs::path path : pathsStr) {
+		if (!is_directory(path)) {
+			networkPaths.push_back(path);
+			continue;
+		}
+		for (const auto &entry : fs::recursive_directory_iterator(path)) {
+			if (entry.is_regular_file() && entry.path().extension() == ".splnet")
+				networkPaths.push_back(entry.path());
+		}
+	}
+
+	if (!checkFilesExist(networkPaths)) {
+		std::exit(1);
+	}
+	if (networkPaths.empty()) {
+		fmt::print(std::cerr, "No network files found.\n");
+		std::exit(1);
+	}
+
+	// Start with the largest files, so a big one doesn't end up running alone at the end
+	std::ranges::sort(networkPaths);
+	std::vector<size_t> order(networkPaths.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::vector<uintmax_t> sizes(networkPaths.size());
+	std::ranges::transform(networkPaths, sizes.begin(), [](const auto &path) { return file_size(path); });
+	std::ranges::stable_sort(order, std::greater<>(), [&](size_t i) { return sizes[i]; });
+
+	std::vector<std::optional<std::string>> failures(networkPaths.size());
+	std::atomic<size_t> next = 0;
+	{
+		std::vector<std::jthread> threads;
+		for (unsigned i = 0; i < std::max(1u, threadCount); ++i) {
+			threads.emplace_back([&] {
+				for (auto n = next++; n < order.size(); n = next++) {
+					try {
+						failures[order[n]] = verifyRoundTrip(networkPaths[order[n]]);
+					} catch (const std::exception &err) {
+						failures[order[n]] = err.what();
+					}
+				}
+			});
+		}
+	}
+
+	size_t failureCount = 0;
+	for (size_t i = 0; i < networkPaths.size(); ++i) {
+		if (!failures[i])
+			continue;
+		fmt::print("{}: {}\n", networkPaths[i].string(), *failures[i]);
+		failureCount++;
+	}
+	fmt::print("{} of {} networks round-trip exactly.\n", networkPaths.size() - failureCount, networkPaths.size());
+
+	if (failureCount)
+		std::exit(1);
+}
+void handleSimplify(const argparse::ArgumentParser &arguments) {
+	const fs::path networkPath = arguments.get("NetworkFile");
+	const fs::path outputPath = arguments.get("-o");
+	const auto tolerance = arguments.get<float>("--tolerance");
+	const auto threadCount = arguments.get<unsigned>("--threads");
+
+	if (!checkFileExists(networkPath)) {
+		std::exit(1);
+	}
+
+	// Read before writing, the output may be the input file
+	const auto originalSize = file_size(networkPath);
+	SplineNetwork network(networkPath);
+	const auto diff = RouteSimplifier(network, tolerance).simplify(threadCount);
+
+	size_t removedPoints = 0;
+	for (const auto &[oldRoute, newRoute] : diff.routeChanges.edits | std::views::values)
+		removedPoints += oldRoute.anchors().size() - newRoute.anchors().size();
+
+	network.applyDiff(diff);
+	network.writeToFile(outputPath);
+
+	const auto simplifiedSize = file_size(outputPath);
+	fmt::print("Simplified {} routes, removing {} route points and {} sub-anchors.\n", diff.routeChanges.edits.size(),
+	           removedPoints, diff.anchorChanges.deletions.size());
+	if (simplifiedSize == originalSize) {
+		fmt::print("{} bytes, unchanged.\n", originalSize);
+		return;
+	}
+	const auto change = static_cast<double>(simplifiedSize) - static_cast<double>(originalSize);
+	fmt::print("{} -> {} bytes, {} bytes ({:.1f}%) {}.\n", originalSize, simplifiedSize, std::abs(change),
+	           originalSize ? 100.0 * std::abs(change) / static_cast<double>(originalSize) : 0.0,
+	           change > 0 ? "larger" : "smaller");
+}
+void handleDedup(const argparse::ArgumentParser &arguments) {
+	const fs::path networkPath = arguments.get("NetworkFile");
+	const fs::path outputPath = arguments.get("-o");
+
+	if (!checkFileExists(networkPath)) {
+		std::exit(1);
+	}
+
+	SplineNetwork network(networkPath);
+	auto diff = RouteDeduplicator::deduplicate(network);
+	fmt::print("Removed {} duplicate routes and {} sub-anchors, and updated {} strips.\n",
+	           diff.routeChanges.deletions.size(), diff.anchorChanges.deletions.size(), diff.stripChanges.edits.size());
+
+	network.applyDiff(std::move(diff));
+	network.writeToFile(outputPath);
+}
+void handleTransform(const argparse::ArgumentParser &arguments) {
+	const fs::path networkPath = arguments.get("NetworkFile");
+	const fs::path outputPath = arguments.get("-o");
+	const auto scale = arguments.get<std::vector<float>>("--scale");
+	const auto offset = arguments.get<std::vector<float>>("--translate");
+	const auto bounds = arguments.present<std::vector<float>>("--bounds");
+	const auto anchorClass = arguments.get("--anchors");
+
+	if (!checkFileExists(networkPath)) {
+		std::exit(1);
+	}
+
+	AnchorTransform transform(scale.at(0), scale.at(1), offset.at(0), offset.at(1));
+	if (bounds)
+		transform.limitTo(AnchorTransform::Bounds{bounds->at(0), bounds->at(1), bounds->at(2), bounds->at(3)});
+	transform.limitTo(anchorClass == "hub"     ? AnchorTransform::AnchorClass::Hub
+	                  : anchorClass == "sub"   ? AnchorTransform::AnchorClass::Sub
+	                  : anchorClass == "land"  ? AnchorTransform::AnchorClass::Land
+	                  : anchorClass == "water" ? AnchorTransform::AnchorClass::Water
+	                                           : AnchorTransform::AnchorClass::All);
+
+	SplineNetwork network(networkPath);
+	auto diff = transform.transform(network);
+	const auto movedAnchors = diff.anchorChanges.edits.size();
+	network.applyDiff(std::move(diff));
+	network.writeToFile(outputPath);
+
+	fmt::print("Moved {} of {} anchors.\n", movedAnchors, network.anchors().size());
+}
+void handleMetrics(const argparse::ArgumentParser &arguments) {
+	const fs::path networkPath = arguments.get("NetworkFile");
+	const auto outputPath = arguments.present("-o");
+	const auto outlierCount = arguments.get<size_t>("--outliers");
+
+	if (!checkFileExists(networkPath)) {
+		std::exit(1);
+	}
+
+	const SplineNetwork network(networkPath);
+	const RouteMetrics metrics(network);
+	const auto &routes = metrics.routes();
+	if (routes.empty()) {
+		fmt::print("The network has no routes.\n");
+		return;
+	}
+
+	// Percentiles of one measurement over every route
+	const auto printDistribution = [&](std::string_view name, auto measure) {
+		std::vector<double> values;
+		values.reserve(routes.size());
+		std::ranges::transform(routes, std::back_inserter(values),
+		                       [&](const auto &route) { return static_cast<double>(measure(route)); });
+		std::ranges::sort(values);
+		const auto percentile = [&](double p) { return values[static_cast<size_t>(p * (values.size() - 1))]; };
+		const auto mean = std::accumulate(values.begin(), values.end(), 0.0) / static_cast<double>(values.size());
+		fmt::print("{:<12} {:>10.1f} {:>10.1f} {:>10.1f} {:>10.1f} {:>10.1f} {:>10.1f}\n", name, values.front(),
+		           percentile(0.5), percentile(0.9), percentile(0.99), values.back(), mean);
+	};
+	fmt::print("{} routes\n", routes.size());
+	fmt::print("{:<12} {:>10} {:>10} {:>10} {:>10} {:>10} {:>10}\n", "", "min", "median", "p90", "p99", "max", "mean");
+	printDistribution("segments", [](const auto &route) { return route.segmentCount(); });
+	printDistribution("length", [](const auto &route) { return route.length; });
+	printDistribution("turn", [](const auto &route) { return route.totalTurn; });
+	printDistribution("max turn", [](const auto &route) { return route.maxTurn; });
+
+	// The worst routes by some measure, skipping the ones where it is zero
+	const auto printOutliers = [&](std::string_view description, auto measure) {
+		std::vector<const RouteMetrics::Metrics *> outliers;
+		for (const auto &route : routes) {
+			if (measure(route) > 0)
+				outliers.push_back(&route);
+		}
+		if (outliers.empty())
+			return;
+
+		std::ranges::sort(outliers, std::greater<>(), [&](const auto *route) { return measure(*route); });
+		fmt::print("{} routes {}:\n", outliers.size(), description);
+		for (const auto *route : outliers | std::views::take(outlierCount))
+			fmt::print("\tRoute #{} ({:.4g})\n", route->routeID, static_cast<double>(measure(*route)));
+	};
+	printOutliers("with stacked anchors", [](const auto &route) { return route.stackedAnchors; });
+	printOutliers("with missing anchors", [](const auto &route) { return route.missingAnchors; });
+	// Turning back on itself is almost always a misplaced anchor
+	printOutliers("doubling back on themselves (max turn)",
+	              [](const auto &route) { return route.maxTurn > 150 ? route.maxTurn : 0.0f; });
+	// Much longer than the distance it covers
+	printOutliers("winding more than 3 times their straight distance (length / distance)", [](const auto &route) {
+		return route.chord > 0 && route.length > 3 * route.chord ? route.length / route.chord : 0.0f;
+	});
+
+	if (outputPath)
+		metrics.writeCsv(*outputPath);
+}
+void handleServe(const argparse::ArgumentParser &arguments) {
+	const auto networkFilesStr = arguments.get<std::vector<std::string>>("Networks");
+	const std::vector<fs::path> networkPaths(networkFilesStr.begin(), networkFilesStr.end());
+	const fs::path socketPath = arguments.get("--socket");
+
+	if (!checkFilesExist(networkPaths)) {
+		std::exit(1);
+	}
+
+	NetworkServer server;
+	std::set<std::string> names;
+	for (const auto &path : networkPaths) {
+		auto name = path.stem().string();
+		if (!names.insert(name).second) {
+			fmt::print(std::cerr, "More than one network is named \"{}\", rename one of the files.\n", name);
+			std::exit(1);
+		}
+		server.load(std::move(name), path);
+	}
+
+	try {
+		server.serve(socketPath);
+	} catch (const std::exception &err) {
+		fmt::print(std::cerr, "{}\n", err.what());
+		std::exit(1);
+	}
+}
+void handleArchive(const argparse::ArgumentParser &arguments) {
+	const fs::path archivePath = arguments.get("ArchiveFile");
+	const auto networkFilesStr = arguments.get<std::vector<std::string>>("Networks");
+	const std::vector<fs::path> networkPaths(networkFilesStr.begin(), networkFilesStr.end());
+	const auto name = arguments.present("--name");
+	const auto snapshotInterval = arguments.present<uint32_t>("--snapshot-interval");
+
+	if (!checkFilesExist(networkPaths)) {
+		std::exit(1);
+	}
+	if (name && networkPaths.size() != 1) {
+		fmt::print(std::cerr, "--name can only be used when adding a single network.\n");
+		std::exit(1);
+	}
+
+	NetworkArchive archive = exists(archivePath) ? NetworkArchive(archivePath) : NetworkArchive();
+	if (snapshotInterval)
+		archive.snapshotInterval(std::max(1u, *snapshotInterval));
+
+	for (const auto &path : networkPaths)
+		archive.addVersion(name.value_or(path.stem().string()), path);
+
+	archive.writeToFile(archivePath);
+}
+void handleCheckout(const argparse::ArgumentParser &arguments) {
+	const fs::path archivePath = arguments.get("ArchiveFile");
+	const auto versionName = arguments.get("Version");
+	const fs::path outputPath = arguments.get("-o");
+
+	if (!checkFileExists(archivePath)) {
+		std::exit(1);
+	}
+
+	const NetworkArchive archive(archivePath);
+	const auto version = archive.findVersion(versionName);
+	if (!version) {
+		fmt::print(std::cerr, "{}: No such version in the archive\n", versionName);
+		std::exit(1);
+	}
+
+	const auto data = archive.checkout(*version);
+	std::ofstream outputFile(outputPath, std::ios::out | std::ios::binary | std::ios::trunc);
+	outputFile.write(data.data(), static_cast<std::streamsize>(data.size()));
+}
+void handleLog(const argparse::ArgumentParser &arguments) {
+	const fs::path archivePath = arguments.get("ArchiveFile");
+
+	if (!checkFileExists(archivePath)) {
+		std::exit(1);
+	}
+
+	const NetworkArchive archive(archivePath);
+	const auto &versions = archive.versions();
+	for (size_t i = 0; i < versions.size(); ++i) {
+		const auto &version = versions[i];
+		fmt::print("{:>4} {} ({}, {} bytes stored)\n", i, version.name, version.isSnapshot ? "snapshot" : "diff",
+		           version.data.size());
+		if (i == 0)
+			continue;
+
+		constexpr std::array itemNames = {"anchors", "strips", "routes"};
+		for (size_t item = 0; item < itemNames.size(); ++item) {
+			const auto &[additions, deletions, edits] = version.changes[item];
+			fmt::print("\t{:<8} +{} -{} ~{}\n", itemNames[item], additions, deletions, edits);
+		}
+	}
+}
 
 int main(int argc, char *argv[]) {
 	const auto reindexEpilog = "This will reindex Sub-Anchors and Route IDs, "
@@ -114,6 +904,35 @@ int main(int argc, char *argv[]) {
 	argparse::ArgumentParser program(program_name, globals::programVersion);
 	program.add_description("A utility to manipulate the .splnet files that describe the road network in Victoria 3.");
 
+	const auto addConflictArgument = [](argparse::ArgumentParser &parser, std::string_view sides) {
+		parser.add_argument("--on-conflict")
+		    .help(fmt::format("What to do with items the {} leave in different states, 'fail', 'prefer-deletions' "
+		                      "to delete anything one deletes and another edits, 'prefer-first', or 'prefer-last'. "
+		                      "Optional, defaults to 'fail'.",
+		                      sides))
+		    .choices("fail", "prefer-deletions", "prefer-first", "prefer-last")
+		    .default_value("fail")
+		    .metavar("POLICY");
+	};
+	const auto addMergeArguments = [&](argparse::ArgumentParser &parser, bool isDriver) {
+		addConflictArgument(parser, "networks");
+		if (!isDriver) {
+			parser.add_argument("--weld")
+			    .help("Weld hub anchors added by more than one network into one if they have the same id or are "
+			          "within this many pixels of each other, instead of refusing to merge. Optional.")
+			    .metavar("PIXELS")
+			    .scan<'g', float>();
+			parser.add_argument("--dedup")
+			    .help("Drop routes running through the same anchors as a route from an earlier network, "
+			          "using that one in their strips instead.")
+			    .flag();
+			parser.add_argument("--conflict-report")
+			    .help("Write every item changed by more than one network to this json file, "
+			          "even if the merge is refused. Optional.")
+			    .metavar("FILE");
+		}
+	};
+
 	argparse::ArgumentParser mergeParser("merge");
 	mergeParser
 	    .add_description("Merge the changes made in the edited networks as compared to the base network."
@@ -123,12 +942,26 @@ int main(int argc, char *argv[]) {
 	    .help("The output file name. Optional, defaults to 'merged.splnet'.")
 	    .metavar("FILE")
 	    .default_value("merged.splnet");
+	addMergeArguments(mergeParser, false);
 	mergeParser.add_argument("BaseNetwork").help("The base network everything is compared to.");
 	mergeParser.add_argument("EditedNetworks")
 	    .help("The edited networks.")
 	    .remaining()
 	    .nargs(1, std::numeric_limits<size_t>::max());
 
+	argparse::ArgumentParser mergeDriverParser("merge-driver");
+	mergeDriverParser.add_description(
+	    "Three-way merge for use as a git merge driver, writing the result over the current version. "
+	    "Exits with an error, leaving the current version untouched, if both sides added different hub anchors with "
+	    "the same id.");
+	mergeDriverParser.add_epilog("Set up with:\n"
+	                             "  git config merge.splnet.driver \"Vic3MapUtils merge-driver %O %A %B\"\n"
+	                             "  echo '*.splnet merge=splnet' >> .gitattributes");
+	addMergeArguments(mergeDriverParser, true);
+	mergeDriverParser.add_argument("Ancestor").help("The common ancestor version (%O).");
+	mergeDriverParser.add_argument("Current").help("The current version (%A), overwritten with the result.");
+	mergeDriverParser.add_argument("Other").help("The other branch's version (%B).");
+
 	argparse::ArgumentParser generateParser("generate");
 	generateParser.add_description("Generates a network diff file from the original (usually vanilla's) "
 	                               "and the edited (usually your mod's) splnet files.");
@@ -143,8 +976,33 @@ int main(int argc, char *argv[]) {
 	applyParser.add_argument("-o", "--output")
 	    .help("The output file name. Optional, defaults to overriding BaseNetwork.")
 	    .metavar("FILE");
+	addConflictArgument(applyParser, "diffs");
 	applyParser.add_argument("BaseNetwork").help("The base spline network file (Usually vanilla's).");
-	applyParser.add_argument("DiffFile").help("The network change diff file.");
+	applyParser.add_argument("DiffFiles")
+	    .help("The network change diff files. Multiple diffs are applied together, "
+	          "and refused if they change the same thing in different ways.")
+	    .remaining()
+	    .nargs(1, std::numeric_limits<size_t>::max());
+
+	argparse::ArgumentParser composeParser("compose");
+	composeParser.add_description("Combine diffs into one with the same effect as applying them one after another.");
+	composeParser.add_argument("-o", "--output")
+	    .help("The output file name. Optional, defaults to 'diff.json'.")
+	    .default_value("diff.json")
+	    .metavar("FILE");
+	composeParser.add_argument("DiffFiles")
+	    .help("The diff files, in the order they would be applied. "
+	          "Each one has to be made against the network the ones before it produce.")
+	    .remaining()
+	    .nargs(2, std::numeric_limits<size_t>::max());
+
+	argparse::ArgumentParser invertParser("invert");
+	invertParser.add_description("Turn a diff into one that undoes it.");
+	invertParser.add_argument("-o", "--output")
+	    .help("The output file name. Optional, defaults to 'inverted.json'.")
+	    .default_value("inverted.json")
+	    .metavar("FILE");
+	invertParser.add_argument("DiffFile").help("The diff file to invert.");
 
 	argparse::ArgumentParser fullMergeParser("full-merge");
 	fullMergeParser
@@ -154,6 +1012,7 @@ int main(int argc, char *argv[]) {
 	    .help("The output file name. Optional, defaults to 'merged.splnet'.")
 	    .default_value("merged.splnet")
 	    .metavar("FILE");
+	addMergeArguments(fullMergeParser, false);
 	fullMergeParser.add_argument("Networks")
 	    .help("Network files to merge.")
 	    .remaining()
@@ -175,12 +1034,264 @@ int main(int argc, char *argv[]) {
 	    .default_value("spline_network.splnet");
 	importParser.add_argument("JsonFile").help("The json file to import.");
 
+	argparse::ArgumentParser indexParser("index");
+	indexParser.add_description("Create a .splidx index next to the network file, allowing fast lookups with 'show'. "
+	                            "Any existing index is kept up to date when the network is written by this utility.");
+	indexParser.add_argument("NetworkFile").help("The network file to index.");
+
+	argparse::ArgumentParser showParser("show");
+	showParser.add_description("Print single anchors, routes, or strips from an indexed network as json, "
+	                           "without parsing the whole file.");
+	showParser.add_argument("-a", "--anchor")
+	    .help("Full ID of an anchor to show, may be given multiple times.")
+	    .metavar("ID")
+	    .scan<'i', uint32_t>()
+	    .default_value(std::vector<uint32_t>{})
+	    .append();
+	showParser.add_argument("-r", "--route")
+	    .help("ID of a route to show, may be given multiple times.")
+	    .metavar("ID")
+	    .scan<'i', uint32_t>()
+	    .default_value(std::vector<uint32_t>{})
+	    .append();
+	showParser.add_argument("-s", "--strip")
+	    .help("Full source and destination hub IDs of a strip to show, may be given multiple times.")
+	    .metavar("SOURCE DESTINATION")
+	    .nargs(2)
+	    .scan<'i', uint32_t>()
+	    .default_value(std::vector<uint32_t>{})
+	    .append();
+	showParser.add_argument("NetworkFile").help("The indexed network file.");
+
+	argparse::ArgumentParser renderParser("render");
+	renderParser.add_description("Draw the network to an image, with routes coloured by the type of their strip.");
+	renderParser.add_argument("-o", "--output")
+	    .help("The output file name, written as PPM if it ends in '.ppm', otherwise PNG. "
+	          "Optional, defaults to 'network.png'.")
+	    .default_value("network.png")
+	    .metavar("FILE");
+	renderParser.add_argument("-p", "--provinces")
+	    .help("A provinces.png to draw underneath the network, the image will have the same size.")
+	    .metavar("FILE");
+	renderParser.add_argument("-s", "--size")
+	    .help("The size of the image when no provinces are given. Optional, defaults to the vanilla map size.")
+	    .metavar("WIDTH HEIGHT")
+	    .nargs(2)
+	    .scan<'u', uint32_t>()
+	    .default_value(std::vector<uint32_t>{8192, 3616});
+	renderParser.add_argument("-d", "--diff")
+	    .help("Highlight the changes compared to this base network instead. "
+	          "Additions are drawn in green, deletions in red, and edits in yellow.")
+	    .metavar("BASE_NETWORK");
+	renderParser.add_argument("-j", "--threads")
+	    .help("The number of threads to render with. Optional, defaults to the number of cores.")
+	    .metavar("N")
+	    .scan<'u', unsigned>()
+	    .default_value(std::max(1u, std::thread::hardware_concurrency()));
+	renderParser.add_argument("NetworkFile").help("The network file to render.");
+
+	argparse::ArgumentParser provincesParser("provinces");
+	provincesParser.add_description("Find which province every anchor is in, and report the number of anchors and "
+	                                "strips in every province along with any misplaced anchors.");
+	provincesParser.add_argument("-o", "--output")
+	    .help("The output file name. Optional, defaults to 'provinces.json'.")
+	    .default_value("provinces.json")
+	    .metavar("FILE");
+	provincesParser.add_argument("-d", "--default-map")
+	    .help("The map_data/default.map file, used to report anchors on the wrong side of the coast.")
+	    .metavar("FILE");
+	provincesParser.add_argument("-s", "--state-regions")
+	    .help("The common/history/state_regions directory, used to report anchors in provinces without a state.")
+	    .metavar("DIRECTORY");
+	provincesParser.add_argument("ProvincesFile").help("The provinces.png the network is placed on.");
+	provincesParser.add_argument("NetworkFile").help("The network file to check.");
+
+	const auto typeHelp = "Only follow strips of this type, may be given multiple times. "
+	                      "One of dirt-road, railroad, sea, or port. Optional, defaults to all types.";
+
+	argparse::ArgumentParser pathParser("path");
+	pathParser.add_description("Find the shortest path between two hub anchors, along the routes of the strips.");
+	pathParser.add_argument("-t", "--type")
+	    .help(typeHelp)
+	    .metavar("TYPE")
+	    .default_value(std::vector<std::string>{})
+	    .append();
+	pathParser.add_argument("NetworkFile").help("The network file to search.");
+	pathParser.add_argument("From").help("The full ID of the starting hub anchor.").scan<'i', uint32_t>();
+	pathParser.add_argument("To").help("The full ID of the destination hub anchor.").scan<'i', uint32_t>();
+
+	argparse::ArgumentParser componentsParser("components");
+	componentsParser.add_description("List the groups of hub anchors that are connected to each other by strips.");
+	componentsParser.add_argument("-o", "--output")
+	    .help("Write the anchor IDs of every component to this json file. Optional.")
+	    .metavar("FILE");
+	componentsParser.add_argument("-t", "--type")
+	    .help(typeHelp)
+	    .metavar("TYPE")
+	    .default_value(std::vector<std::string>{})
+	    .append();
+	componentsParser.add_argument("NetworkFile").help("The network file to analyse.");
+
+	argparse::ArgumentParser archiveParser("archive");
+	archiveParser.add_description("Add network versions to an archive, creating it if it doesn't exist. "
+	                              "Versions are stored as diffs against the previous one, with periodic snapshots.");
+	archiveParser.add_argument("-n", "--name")
+	    .help("The name of the version. Optional, defaults to the file name without extension.")
+	    .metavar("NAME");
+	archiveParser.add_argument("-s", "--snapshot-interval")
+	    .help("Store every Nth version as a full snapshot. Optional, defaults to 16 for new archives.")
+	    .metavar("N")
+	    .scan<'u', uint32_t>();
+	archiveParser.add_argument("ArchiveFile").help("The archive file.");
+	archiveParser.add_argument("Networks")
+	    .help("Network files to add, oldest first.")
+	    .remaining()
+	    .nargs(1, std::numeric_limits<size_t>::max());
+
+	argparse::ArgumentParser checkoutParser("checkout");
+	checkoutParser.add_description("Extract a version from a network archive.");
+	checkoutParser.add_argument("-o", "--output")
+	    .help("The output file name. Optional, defaults to 'spline_network.splnet'.")
+	    .default_value("spline_network.splnet")
+	    .metavar("FILE");
+	checkoutParser.add_argument("ArchiveFile").help("The archive file.");
+	checkoutParser.add_argument("Version").help("The name or index of the version.");
+
+	argparse::ArgumentParser logParser("log");
+	logParser.add_description("List the versions in a network archive, and what changed between them.");
+	logParser.add_argument("ArchiveFile").help("The archive file.");
+
+	argparse::ArgumentParser verifyParser("verify");
+	verifyParser.add_description("Check that networks are written back byte for byte identical after being read, "
+	                             "reporting where the first difference is for any that aren't.");
+	verifyParser.add_argument("-j", "--threads")
+	    .help("The number of files to verify at once. Optional, defaults to the number of cores.")
+	    .metavar("N")
+	    .scan<'u', unsigned>()
+	    .default_value(std::max(1u, std::thread::hardware_concurrency()));
+	verifyParser.add_argument("Paths")
+	    .help("Network files, or directories to search for .splnet files.")
+	    .remaining()
+	    .nargs(1, std::numeric_limits<size_t>::max());
+
+	argparse::ArgumentParser serveParser("serve");
+	serveParser.add_description("Keep networks in memory and answer queries about them over a local socket.");
+	serveParser.add_epilog(
+	    "Requests and responses are JSON objects, one per line. Every request has a \"command\", and a \"network\"\n"
+	    "naming the file it is about, without the extension, if more than one is loaded. An \"id\" is echoed back.\n"
+	    "Responses have \"ok\", and either a \"result\" or an \"error\".\n"
+	    "\n"
+	    "  {\"command\": \"list\"}\n"
+	    "  {\"command\": \"lookup\", \"anchor\": ID} or \"route\": ID, or \"strip\": [SOURCE, DESTINATION]\n"
+	    "  {\"command\": \"nearby\", \"x\": X, \"y\": Y, \"radius\": 10, \"limit\": 100, \"hubs\": false}\n"
+	    "  {\"command\": \"diff\", \"file\": PATH, \"summary\": false}\n"
+	    "  {\"command\": \"reload\", \"file\": PATH} with the file defaulting to the one loaded before");
+	serveParser.add_argument("-s", "--socket")
+	    .help("The socket to listen on. Optional, defaults to 'vic3maputils.sock'.")
+	    .default_value("vic3maputils.sock")
+	    .metavar("PATH");
+	serveParser.add_argument("Networks")
+	    .help("The network files to load.")
+	    .remaining()
+	    .nargs(1, std::numeric_limits<size_t>::max());
+
+	argparse::ArgumentParser simplifyParser("simplify");
+	simplifyParser.add_description("Remove sub-anchors that barely change the shape of their routes. "
+	                               "Hub anchors and the ends of routes are never removed.");
+	simplifyParser.add_argument("-o", "--output")
+	    .help("The output file name. Optional, defaults to 'simplified.splnet'.")
+	    .default_value("simplified.splnet")
+	    .metavar("FILE");
+	simplifyParser.add_argument("-t", "--tolerance")
+	    .help("How far, in pixels, a removed sub-anchor may be from the simplified route. Optional, defaults to 0.5.")
+	    .metavar("PIXELS")
+	    .scan<'g', float>()
+	    .default_value(0.5f);
+	simplifyParser.add_argument("-j", "--threads")
+	    .help("The number of threads to simplify with. Optional, defaults to the number of cores.")
+	    .metavar("N")
+	    .scan<'u', unsigned>()
+	    .default_value(std::max(1u, std::thread::hardware_concurrency()));
+	simplifyParser.add_argument("NetworkFile").help("The network file to simplify.");
+
+	argparse::ArgumentParser dedupParser("dedup");
+	dedupParser.add_description("Remove routes running through the same anchors as another route, using that one in "
+	                            "their strips instead. Sub-anchors are compared by position.");
+	dedupParser.add_argument("-o", "--output")
+	    .help("The output file name. Optional, defaults to 'deduplicated.splnet'.")
+	    .default_value("deduplicated.splnet")
+	    .metavar("FILE");
+	dedupParser.add_argument("NetworkFile").help("The network file to deduplicate.");
+
+	argparse::ArgumentParser transformParser("transform");
+	transformParser.add_description("Scale and then move anchor positions, to follow the map when it is resized or "
+	                                "shifted. Positions are in provinces.png pixels with (0, 0) at the bottom left.");
+	transformParser.add_argument("-o", "--output")
+	    .help("The output file name. Optional, defaults to 'transformed.splnet'.")
+	    .default_value("transformed.splnet")
+	    .metavar("FILE");
+	transformParser.add_argument("-s", "--scale")
+	    .help("Multiply positions by these factors. Optional, defaults to 1 1.")
+	    .metavar("X Y")
+	    .nargs(2)
+	    .scan<'g', float>()
+	    .default_value(std::vector<float>{1, 1});
+	transformParser.add_argument("-t", "--translate")
+	    .help("Add these offsets to positions, after scaling. Optional, defaults to 0 0.")
+	    .metavar("X Y")
+	    .nargs(2)
+	    .scan<'g', float>()
+	    .default_value(std::vector<float>{0, 0});
+	transformParser.add_argument("-b", "--bounds")
+	    .help("Only transform anchors within this box, inclusive. Optional.")
+	    .metavar("MIN_X MIN_Y MAX_X MAX_Y")
+	    .nargs(4)
+	    .scan<'g', float>();
+	transformParser.add_argument("-a", "--anchors")
+	    .help("Only transform this class of anchors, 'all', 'hub', 'sub', 'land', or 'water'. "
+	          "Optional, defaults to 'all'.")
+	    .choices("all", "hub", "sub", "land", "water")
+	    .default_value("all")
+	    .metavar("CLASS");
+	transformParser.add_argument("NetworkFile").help("The network file to transform.");
+
+	argparse::ArgumentParser metricsParser("metrics");
+	metricsParser.add_description("Measure the length, segments, and turns of every route, "
+	                              "and list routes that look broken.");
+	metricsParser.add_argument("-o", "--output")
+	    .help("Write the measurements of every route to this CSV file. Optional.")
+	    .metavar("FILE");
+	metricsParser.add_argument("-n", "--outliers")
+	    .help("The number of routes to list for each kind of outlier. Optional, defaults to 10.")
+	    .metavar("N")
+	    .scan<'u', size_t>()
+	    .default_value(size_t(10));
+	metricsParser.add_argument("NetworkFile").help("The network file to measure.");
+
 	program.add_subparser(mergeParser);
+	program.add_subparser(mergeDriverParser);
 	program.add_subparser(generateParser);
 	program.add_subparser(applyParser);
+	program.add_subparser(composeParser);
+	program.add_subparser(invertParser);
 	program.add_subparser(fullMergeParser);
 	program.add_subparser(exportParser);
 	program.add_subparser(importParser);
+	program.add_subparser(indexParser);
+	program.add_subparser(showParser);
+	program.add_subparser(renderParser);
+	program.add_subparser(provincesParser);
+	program.add_subparser(pathParser);
+	program.add_subparser(componentsParser);
+	program.add_subparser(archiveParser);
+	program.add_subparser(checkoutParser);
+	program.add_subparser(logParser);
+	program.add_subparser(verifyParser);
+	program.add_subparser(simplifyParser);
+	program.add_subparser(dedupParser);
+	program.add_subparser(transformParser);
+	program.add_subparser(metricsParser);
+	program.add_subparser(serveParser);
 
 	try {
 		program.parse_args(argc, argv);
@@ -194,6 +1305,10 @@ int main(int argc, char *argv[]) {
 		handleMerge(mergeParser);
 		return 0;
 	}
+	if (program.is_subcommand_used(mergeDriverParser)) {
+		handleMergeDriver(mergeDriverParser);
+		return 0;
+	}
 	if (program.is_subcommand_used(generateParser)) {
 		handleGenerate(generateParser);
 		return 0;
@@ -202,6 +1317,14 @@ int main(int argc, char *argv[]) {
 		handleApply(applyParser);
 		return 0;
 	}
+	if (program.is_subcommand_used(composeParser)) {
+		handleCompose(composeParser);
+		return 0;
+	}
+	if (program.is_subcommand_used(invertParser)) {
+		handleInvert(invertParser);
+		return 0;
+	}
 	if (program.is_subcommand_used(fullMergeParser)) {
 		handleFullMerge(fullMergeParser);
 		return 0;
@@ -214,4 +1337,64 @@ int main(int argc, char *argv[]) {
 		handleImport(importParser);
 		return 0;
 	}
+	if (program.is_subcommand_used(indexParser)) {
+		handleIndex(indexParser);
+		return 0;
+	}
+	if (program.is_subcommand_used(showParser)) {
+		handleShow(showParser);
+		return 0;
+	}
+	if (program.is_subcommand_used(renderParser)) {
+		handleRender(renderParser);
+		return 0;
+	}
+	if (program.is_subcommand_used(provincesParser)) {
+		handleProvinces(provincesParser);
+		return 0;
+	}
+	if (program.is_subcommand_used(pathParser)) {
+		handlePath(pathParser);
+		return 0;
+	}
+	if (program.is_subcommand_used(componentsParser)) {
+		handleComponents(componentsParser);
+		return 0;
+	}
+	if (program.is_subcommand_used(archiveParser)) {
+		handleArchive(archiveParser);
+		return 0;
+	}
+	if (program.is_subcommand_used(checkoutParser)) {
+		handleCheckout(checkoutParser);
+		return 0;
+	}
+	if (program.is_subcommand_used(logParser)) {
+		handleLog(logParser);
+		return 0;
+	}
+	if (program.is_subcommand_used(verifyParser)) {
+		handleVerify(verifyParser);
+		return 0;
+	}
+	if (program.is_subcommand_used(simplifyParser)) {
+		handleSimplify(simplifyParser);
+		return 0;
+	}
+	if (program.is_subcommand_used(dedupParser)) {
+		handleDedup(dedupParser);
+		return 0;
+	}
+	if (program.is_subcommand_used(transformParser)) {
+		handleTransform(transformParser);
+		return 0;
+	}
+	if (program.is_subcommand_used(metricsParser)) {
+		handleMetrics(metricsParser);
+		return 0;
+	}
+	if (program.is_subcommand_used(serveParser)) {
+		handleServe(serveParser);
+		return 0;
+	}
 }
@@ -0,0 +1,87 @@
+// Transforms the anchors of a small network and checks which ones move and where to
+// Usage: AnchorTransformTest
+
+#include "TestNetworks.hpp"
+
+#include "SplineNetwork/AnchorTransform.hpp"
+
+using namespace test;
+
+namespace {
+	/// Land and water hub and sub-anchors along the x axis, enough of them to need both the batch and the tail
+	SplineNetwork network() {
+		Diff diff;
+		for (uint32_t i = 1; i <= 3; ++i) {
+			add(diff, anchor(i, static_cast<float>(i) * 10, 0));
+			add(diff, anchor(i | subAnchorBit, static_cast<float>(i) * 10 + 5, 0));
+			add(diff, anchor(i | waterBit, static_cast<float>(i) * 10, 20));
+		}
+
+		SplineNetwork network;
+		network.applyDiff(std::move(diff));
+		return network;
+	}
+
+	/// The ids of the anchors moved by `diff`
+	std::vector<uint32_t> moved(const Diff &diff) {
+		std::vector<uint32_t> ids;
+		for (const auto &id : diff.anchorChanges.edits | std::views::keys)
+			ids.push_back(id);
+		return ids;
+	}
+
+	void everything() {
+		const auto source = network();
+		const auto diff = AnchorTransform(2, 3, 1, -1).transform(source);
+		check(diff.anchorChanges.edits.size() == source.anchors().size(), "every anchor moves");
+		check(diff.anchorChanges.additions.empty() && diff.anchorChanges.deletions.empty(),
+		      "transforming only edits anchors");
+
+		bool allCorrect = true;
+		for (const auto &[id, versions] : diff.anchorChanges.edits) {
+			const auto &[before, after] = versions;
+			allCorrect &= before == source.anchors().at(id);
+			allCorrect &= after.posX() == before.posX() * 2 + 1 && after.posY() == before.posY() * 3 - 1;
+		}
+		check(allCorrect, "positions are scaled and then offset");
+
+		check(AnchorTransform(1, 1, 0, 0).transform(source).anchorChanges.edits.empty(),
+		      "anchors that don't move aren't edited");
+	}
+
+	void classes() {
+		const auto source = network();
+		const auto select = [&](AnchorTransform::AnchorClass anchorClass) {
+			AnchorTransform transform(1, 1, 5, 5);
+			transform.limitTo(anchorClass);
+			return moved(transform.transform(source));
+		};
+		using Class = AnchorTransform::AnchorClass;
+		check(select(Class::Hub) == std::vector<uint32_t>{1, 2, 3, 1 | waterBit, 2 | waterBit, 3 | waterBit},
+		      "only hub anchors move");
+		check(select(Class::Sub) == std::vector<uint32_t>{1 | subAnchorBit, 2 | subAnchorBit, 3 | subAnchorBit},
+		      "only sub-anchors move");
+		check(select(Class::Water) == std::vector<uint32_t>{1 | waterBit, 2 | waterBit, 3 | waterBit},
+		      "only water anchors move");
+		check(select(Class::Land).size() == 6, "only land anchors move");
+	}
+
+	void bounds() {
+		const auto source = network();
+		AnchorTransform transform(1, 1, 0, 100);
+		transform.limitTo(AnchorTransform::Bounds{10, 0, 20, 0});
+		check(moved(transform.transform(source)) == std::vector<uint32_t>{1, 2, 1 | subAnchorBit},
+		      "only anchors within the bounds, edges included, move");
+
+		transform.limitTo(AnchorTransform::AnchorClass::Hub);
+		check(moved(transform.transform(source)) == std::vector<uint32_t>{1, 2},
+		      "bounds and classes both have to select an anchor");
+	}
+} // namespace
+
+int main() {
+	everything();
+	classes();
+	bounds();
+	return failures ? 1 : 0;
+}
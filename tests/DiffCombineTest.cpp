@@ -0,0 +1,79 @@
+// Applies diffs together and checks the same item added by several of them is only added once
+// Usage: DiffCombineTest
+
+#include "TestNetworks.hpp"
+
+using namespace test;
+
+namespace {
+	/// A small network with two hub anchors and a route between them over a sub-anchor
+	SplineNetwork baseNetwork() {
+		Diff diff;
+		add(diff, anchor(1, 0, 0));
+		add(diff, anchor(2, 10, 0));
+		add(diff, anchor(1 | subAnchorBit, 5, 1));
+		add(diff, route(1 << 8, {1, 1 | subAnchorBit, 2}));
+		add(diff, strip(1, 2, {1 << 8}));
+
+		SplineNetwork network;
+		network.applyDiff(std::move(diff));
+		return network;
+	}
+
+	/// Adds a hub anchor connected to an existing one, over a sub-anchor whose id the base network already uses
+	Diff branch(uint32_t hub, float x) {
+		Diff diff;
+		add(diff, anchor(hub, x, 5));
+		add(diff, anchor(1 | subAnchorBit, x / 2, 3));
+		add(diff, route(1 << 8, {1, 1 | subAnchorBit, hub}));
+		add(diff, strip(1, hub, {1 << 8}));
+		return diff;
+	}
+
+	void sameDiffTwice() {
+		auto once = baseNetwork();
+		once.applyDiff(branch(3, 20));
+
+		auto twice = baseNetwork();
+		twice.applyDiffs({branch(3, 20), branch(3, 20)});
+		check(sameNetwork(once, twice), "applying a diff twice at once adds the same items as applying it once");
+		check(twice.anchors().size() == 5, "the remapped sub-anchor is only added once");
+	}
+
+	void differentSubAnchorsWithSameId() {
+		auto network = baseNetwork();
+		network.applyDiffs({branch(3, 20), branch(4, 40)});
+		check(network.anchors().size() == 7, "different sub-anchors with the same id are both added");
+		check(network.routes().size() == 3, "different routes with the same id are both added");
+		check(network.strips().size() == 3, "both strips are added");
+	}
+
+	void identicalHubAnchors() {
+		Diff first;
+		add(first, anchor(5, 50, 50));
+		Diff second = first;
+		add(second, anchor(6, 60, 60));
+
+		auto network = baseNetwork();
+		network.applyDiffs({std::move(first), std::move(second)});
+		check(network.anchors().contains(5) && network.anchors().contains(6),
+		      "a hub anchor added identically by two diffs is added once");
+
+		Diff moved;
+		add(moved, anchor(5, 51, 50));
+		Diff other;
+		add(other, anchor(5, 50, 50));
+		auto refused = baseNetwork();
+		const auto before = refused;
+		checkThrows([&] { refused.applyDiffs({std::move(moved), std::move(other)}); },
+		            "different hub anchors with the same id are refused");
+		check(sameNetwork(refused, before), "a refused combination leaves the network unchanged");
+	}
+} // namespace
+
+int main() {
+	sameDiffTwice();
+	differentSubAnchorsWithSameId();
+	identicalHubAnchors();
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,116 @@
+// Composes and inverts diffs and checks the result has the same effect as applying them one after the other
+// Usage: DiffComposeTest
+
+#include "TestNetworks.hpp"
+
+using namespace test;
+
+namespace {
+	/// Two hub anchors and a route between them over a sub-anchor
+	SplineNetwork baseNetwork() {
+		Diff diff;
+		add(diff, anchor(1, 0, 0));
+		add(diff, anchor(2, 10, 0));
+		add(diff, anchor(1 | subAnchorBit, 5, 1));
+		add(diff, route(1 << 8, {1, 1 | subAnchorBit, 2}));
+		add(diff, strip(1, 2, {1 << 8}));
+
+		SplineNetwork network;
+		network.applyDiff(std::move(diff));
+		return network;
+	}
+
+	Diff moveAnchor(uint32_t id, Anchor from, float x, float y) {
+		Diff diff;
+		diff.anchorChanges.edits.emplace(id, std::pair(from, anchor(id, x, y)));
+		return diff;
+	}
+
+	bool isEmpty(const Diff &diff) {
+		return diff.anchorChanges.additions.empty() && diff.anchorChanges.deletions.empty() &&
+		       diff.anchorChanges.edits.empty() && diff.routeChanges.additions.empty() &&
+		       diff.routeChanges.deletions.empty() && diff.routeChanges.edits.empty() &&
+		       diff.stripChanges.additions.empty() && diff.stripChanges.deletions.empty() &&
+		       diff.stripChanges.edits.empty();
+	}
+
+	void addThenDeleteCancels() {
+		Diff added;
+		add(added, anchor(3, 20, 0));
+		add(added, route(2 << 8, {2, 3}));
+		Diff deleted;
+		deleted.anchorChanges.deletions.emplace(3, anchor(3, 20, 0));
+		deleted.routeChanges.deletions.emplace(2 << 8, route(2 << 8, {2, 3}));
+
+		check(isEmpty(Diff::compose(std::move(added), std::move(deleted))), "adding and then deleting cancels out");
+	}
+
+	void editChainsCollapse() {
+		const uint32_t id = 1 | subAnchorBit;
+		const auto start = anchor(id, 5, 1);
+		const auto middle = anchor(id, 6, 1);
+		auto composed = Diff::compose(moveAnchor(id, start, 6, 1), moveAnchor(id, middle, 7, 2));
+		const auto &edits = composed.anchorChanges.edits;
+		check(edits.size() == 1, "two edits of the same anchor collapse into one");
+		check(edits.size() == 1 && edits.begin()->second == std::pair(start, anchor(id, 7, 2)),
+		      "the collapsed edit goes from the first version to the last");
+
+		auto sequential = baseNetwork();
+		sequential.applyDiff(moveAnchor(id, start, 6, 1));
+		sequential.applyDiff(moveAnchor(id, middle, 7, 2));
+		auto once = baseNetwork();
+		once.applyDiff(composed);
+		check(sameNetwork(sequential, once), "the composed diff has the same effect as both in order");
+
+		check(isEmpty(Diff::compose(moveAnchor(id, start, 6, 1), moveAnchor(id, middle, 5, 1))),
+		      "an edit moved back where it started is dropped");
+	}
+
+	void deleteThenAddBecomesEdit() {
+		Diff deleted;
+		deleted.routeChanges.deletions.emplace(1 << 8, route(1 << 8, {1, 1 | subAnchorBit, 2}));
+		Diff added;
+		add(added, route(1 << 8, {1, 2}));
+
+		auto composed = Diff::compose(std::move(deleted), std::move(added));
+		check(composed.routeChanges.edits.size() == 1 && composed.routeChanges.additions.empty() &&
+		          composed.routeChanges.deletions.empty(),
+		      "deleting a route and adding it back differently is an edit");
+	}
+
+	void addingExistingItemIsRefused() {
+		Diff first;
+		add(first, anchor(3, 20, 0));
+		Diff second;
+		add(second, anchor(3, 30, 0));
+		checkThrows([&] { Diff::compose(std::move(first), std::move(second)); },
+		            "adding an anchor the first diff already added is refused");
+	}
+
+	void invertUndoes() {
+		Diff diff = moveAnchor(1 | subAnchorBit, anchor(1 | subAnchorBit, 5, 1), 6, 3);
+		add(diff, anchor(3, 20, 0));
+		add(diff, route(2 << 8, {2, 3}));
+		add(diff, strip(2, 3, {2 << 8}));
+		diff.routeChanges.deletions.emplace(1 << 8, route(1 << 8, {1, 1 | subAnchorBit, 2}));
+
+		auto inverse = diff;
+		inverse.invert();
+		check(isEmpty(Diff::compose(diff, inverse)), "a diff composed with its inverse is empty");
+
+		const auto original = baseNetwork();
+		auto network = original;
+		network.applyDiff(diff);
+		network.applyDiff(inverse);
+		check(sameNetwork(network, original), "applying the inverse puts the network back");
+	}
+} // namespace
+
+int main() {
+	addThenDeleteCancels();
+	editChainsCollapse();
+	deleteThenAddBecomesEdit();
+	addingExistingItemIsRefused();
+	invertUndoes();
+	return failures ? 1 : 0;
+}
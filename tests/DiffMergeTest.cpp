@@ -0,0 +1,107 @@
+// Merges and combines diffs changing the same items, and checks both classify and resolve the overlaps the same way
+// Usage: DiffMergeTest
+
+#include "TestNetworks.hpp"
+
+using namespace test;
+
+namespace {
+	const auto original = anchor(1, 0, 0);
+	const auto movedLeft = anchor(1, -5, 0);
+	const auto movedRight = anchor(1, 5, 0);
+
+	Diff edit(const Anchor &to) {
+		Diff diff;
+		diff.anchorChanges.edits.emplace(1, std::pair(original, to));
+		return diff;
+	}
+	Diff deletion() {
+		Diff diff;
+		diff.anchorChanges.deletions.emplace(1, original);
+		return diff;
+	}
+
+	/// Merges `second` into `first` and combines them, checking both end up with the same anchor changes and report
+	/// Returns the merged diff, or nullopt if either refused
+	std::optional<Diff> mergeAndCombine(Diff first, Diff second, ConflictPolicy policy, MergeReport &report,
+	                                    std::string_view what) {
+		MergeOptions options;
+		options.policy = policy;
+		std::optional<Diff> merged = first;
+		try {
+			merged->mergeDiff(second, options, &report);
+		} catch (const std::exception &) {
+			merged.reset();
+		}
+
+		std::optional<Diff> combined;
+		MergeReport combineReport;
+		ReservedIds anchorIds;
+		ReservedIds routeIds;
+		try {
+			combined =
+			    Diff::combine({std::move(first), std::move(second)}, anchorIds, routeIds, policy, &combineReport);
+		} catch (const std::exception &) {
+		}
+
+		check(merged.has_value() == combined.has_value(),
+		      fmt::format("{}: merge and combine both refuse or not", what));
+		if (merged && combined)
+			check(nlohmann::json(*merged) == nlohmann::json(*combined),
+			      fmt::format("{}: merge and combine give the same changes", what));
+		check(nlohmann::json(report) == nlohmann::json(combineReport),
+		      fmt::format("{}: merge and combine report the same overlaps", what));
+		return merged;
+	}
+
+	void identicalEdits() {
+		MergeReport report;
+		const auto merged =
+		    mergeAndCombine(edit(movedLeft), edit(movedLeft), ConflictPolicy::Fail, report, "identical");
+		check(merged && merged->anchorChanges.edits.at(1).second == movedLeft, "identical edits are kept");
+		check(report.identical == 1 && report.conflicts.empty(), "identical edits are not a conflict");
+	}
+
+	void editAgainstDeletion() {
+		MergeReport failReport;
+		check(!mergeAndCombine(edit(movedLeft), deletion(), ConflictPolicy::Fail, failReport, "edit then delete"),
+		      "an edit and a deletion are refused by default");
+		check(failReport.conflicts.size() == 1 && failReport.conflicts[0].secondAction == "deleted",
+		      "an edit and a deletion are reported as a conflict");
+
+		for (const auto &[first, second] :
+		     {std::pair(edit(movedLeft), deletion()), std::pair(deletion(), edit(movedLeft))}) {
+			MergeReport report;
+			const auto merged =
+			    mergeAndCombine(first, second, ConflictPolicy::PreferDeletions, report, "prefer deletions");
+			check(merged && merged->anchorChanges.deletions.contains(1) && merged->anchorChanges.edits.empty(),
+			      "preferring deletions deletes an item the other side edits");
+			check(report.deletedEdits == 1 && report.conflicts.empty(), "the deletion is counted, not a conflict");
+		}
+	}
+
+	void divergentEdits() {
+		MergeReport failReport;
+		check(!mergeAndCombine(edit(movedLeft), edit(movedRight), ConflictPolicy::PreferDeletions, failReport,
+		                       "divergent edits"),
+		      "divergent edits are refused when only deletions are preferred");
+
+		MergeReport firstReport;
+		const auto first = mergeAndCombine(edit(movedLeft), edit(movedRight), ConflictPolicy::PreferFirst,
+		                                   firstReport, "prefer first");
+		check(first && first->anchorChanges.edits.at(1).second == movedLeft, "preferring the first keeps its edit");
+
+		MergeReport lastReport;
+		const auto last =
+		    mergeAndCombine(edit(movedLeft), edit(movedRight), ConflictPolicy::PreferLast, lastReport, "prefer last");
+		check(last && last->anchorChanges.edits.at(1).second == movedRight, "preferring the last keeps its edit");
+		check(lastReport.conflicts.size() == 1, "a resolved conflict is still reported");
+	}
+} // namespace
+
+int main() {
+	identicalEdits();
+	editAgainstDeletion();
+	divergentEdits();
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,85 @@
+// Welds the hub anchors of one diff onto another's and checks which are welded and how their users are rewritten
+// Usage: DiffWeldTest
+
+#include "TestNetworks.hpp"
+
+using namespace test;
+
+namespace {
+	/// Adds hub anchor `hub` at (x, 0) and a route and strip from hub anchor 1 to it
+	Diff branch(uint32_t hub, float x) {
+		Diff diff;
+		add(diff, anchor(hub, x, 0));
+		add(diff, route(1 << 8, {1, hub}));
+		add(diff, strip(1, hub, {1 << 8}));
+		return diff;
+	}
+
+	void sameIdWithinTolerance() {
+		const auto onto = branch(2, 10);
+		auto diff = branch(2, 10.5f);
+		check(diff.weldHubAnchors(onto, 1) == 1, "a hub anchor with the same id within tolerance is welded");
+		check(!diff.anchorChanges.additions.contains(2), "the welded hub anchor is no longer added");
+		check(diff.routeChanges.additions.at(1 << 8).anchors() == std::vector<uint32_t>{1, 2},
+		      "routes keep using the same id");
+
+		MergeOptions options;
+		options.weldTolerance = 1;
+		auto merged = branch(2, 10);
+		merged.mergeDiff(branch(2, 10.5f), options);
+		check(merged.anchorChanges.additions.size() == 1, "merging with welding adds the hub anchor once");
+	}
+
+	void sameIdBeyondTolerance() {
+		const auto onto = branch(2, 10);
+		auto diff = branch(2, 20);
+		check(diff.weldHubAnchors(onto, 1) == 0, "a hub anchor with the same id further away is not welded");
+		check(diff.anchorChanges.additions.contains(2), "the hub anchor is still added");
+
+		MergeOptions options;
+		options.weldTolerance = 1;
+		auto merged = branch(2, 10);
+		checkThrows([&] { merged.mergeDiff(branch(2, 20), options); },
+		            "different hub anchors with the same id are still refused");
+	}
+
+	void differentIdWithinTolerance() {
+		const auto onto = branch(2, 10);
+		auto diff = branch(3, 10.5f);
+		check(diff.weldHubAnchors(onto, 1) == 1, "a hub anchor with another id within tolerance is welded");
+		check(!diff.anchorChanges.additions.contains(3), "the welded hub anchor is no longer added");
+		check(diff.routeChanges.additions.at(1 << 8).anchors() == std::vector<uint32_t>{1, 2},
+		      "routes are rewritten to the hub anchor welded onto");
+		const auto &strips = diff.stripChanges.additions;
+		check(strips.size() == 1 && strips.begin()->second.destinationID() == 2,
+		      "strips are moved to the hub anchor welded onto");
+		check(strips.begin()->first == strips.begin()->second.idPair(), "moved strips are stored under their new ends");
+
+		auto far = branch(3, 20);
+		check(far.weldHubAnchors(onto, 1) == 0, "a hub anchor with another id further away is not welded");
+	}
+
+	void landIsNotWeldedToWater() {
+		const auto water = 2 | waterBit;
+		const auto onto = branch(water, 10);
+		auto land = branch(3, 10);
+		check(land.weldHubAnchors(onto, 1) == 0, "a land hub anchor is not welded onto a water one");
+		check(land.anchorChanges.additions.contains(3), "the land hub anchor is still added");
+
+		auto otherWater = branch(3 | waterBit, 10.5f);
+		check(otherWater.weldHubAnchors(onto, 1) == 1, "water hub anchors are welded onto each other");
+
+		auto sub = branch(3, 10);
+		sub.anchorChanges.additions.clear();
+		add(sub, anchor(3 | subAnchorBit, 10, 0));
+		check(sub.weldHubAnchors(onto, 1) == 0, "sub-anchors are never welded");
+	}
+} // namespace
+
+int main() {
+	sameIdWithinTolerance();
+	sameIdBeyondTolerance();
+	differentIdWithinTolerance();
+	landIsNotWeldedToWater();
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,72 @@
+// Archives the example networks as versions of one another and checks every version checks out byte for byte
+// Usage: NetworkArchiveTest <directory with .splnet files>
+
+#include <algorithm>
+#include <filesystem>
+
+#include "TestNetworks.hpp"
+
+#include "SplineNetwork/FileHandler/MappedFile.hpp"
+#include "SplineNetwork/NetworkArchive.hpp"
+
+namespace fs = std::filesystem;
+using namespace test;
+
+namespace {
+	bool sameBytes(const std::vector<char> &data, const fs::path &path) {
+		const MappedFile file(path);
+		return std::ranges::equal(data, file.data());
+	}
+
+	/// Every version checks out as the file it was added from
+	void checkVersions(const NetworkArchive &archive, const std::vector<fs::path> &paths, std::string_view what) {
+		bool allSame = archive.versions().size() == paths.size();
+		for (size_t i = 0; allSame && i < paths.size(); ++i)
+			allSame &= sameBytes(archive.checkout(i), paths[i]);
+		check(allSame, fmt::format("{}: every version checks out as the file it was added from", what));
+	}
+} // namespace
+
+int main(int argc, char *argv[]) {
+	if (argc != 2) {
+		fmt::print(std::cerr, "Usage: {} <directory with .splnet files>\n", argv[0]);
+		return 2;
+	}
+
+	const auto directory = fs::temp_directory_path() / "NetworkArchiveTest";
+	fs::create_directories(directory);
+
+	// The edits of the base network, and the same again as written by the tool so they can be stored as diffs
+	std::vector<fs::path> paths;
+	for (const auto name : {"edit_base", "edit_1", "edit_2", "edit_merged"}) {
+		const auto original = fs::path(argv[1]) / fmt::format("{}.splnet", name);
+		const auto rewritten = directory / fmt::format("{}.splnet", name);
+		SplineNetwork(original).writeToFile(rewritten);
+		paths.push_back(original);
+		paths.push_back(rewritten);
+	}
+
+	NetworkArchive archive;
+	archive.snapshotInterval(3);
+	for (const auto &path : paths)
+		archive.addVersion(path.stem().string(), path);
+
+	const auto &versions = archive.versions();
+	check(versions.front().isSnapshot, "the first version is a snapshot");
+	check(std::ranges::any_of(versions, [](const auto &version) { return !version.isSnapshot; }),
+	      "versions written the same way as the previous one are stored as diffs");
+	checkVersions(archive, paths, "in memory");
+
+	const auto archivePath = directory / "archive.splarc";
+	archive.writeToFile(archivePath);
+	const NetworkArchive readBack(archivePath);
+	check(readBack.snapshotInterval() == 3, "the snapshot interval is read back");
+	checkVersions(readBack, paths, "read back");
+
+	check(readBack.findVersion("edit_1") == 3, "the latest version with a name is found");
+	check(readBack.findVersion("2") == 2, "versions are found by index");
+	check(!readBack.findVersion("missing") && !readBack.findVersion("8"), "missing versions are not found");
+
+	fs::remove_all(directory);
+	return failures ? 1 : 0;
+}
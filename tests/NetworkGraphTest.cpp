@@ -0,0 +1,92 @@
+// Searches a small network for shortest paths and connected components
+// Usage: NetworkGraphTest
+
+#include <array>
+#include <cmath>
+
+#include "TestNetworks.hpp"
+
+#include "SplineNetwork/NetworkGraph.hpp"
+
+using namespace test;
+
+namespace {
+	/// Hub anchors 1, 2 and 4 along the x axis, joined by a railroad and a road through 2, and by a winding road
+	/// straight from 1 to 4, with hub anchor 5 off on its own
+	SplineNetwork network() {
+		Diff diff;
+		add(diff, anchor(1, 0, 0));
+		add(diff, anchor(2, 10, 0));
+		add(diff, anchor(4, 20, 0));
+		add(diff, anchor(5, 100, 100));
+		add(diff, anchor(1 | subAnchorBit, 10, 10));
+		add(diff, route(1 << 8 | 1, {1, 2}));
+		add(diff, route(1 << 8, {2, 4}));
+		add(diff, route(2 << 8, {1, 1 | subAnchorBit, 4}));
+		add(diff, strip(1, 2, {1 << 8 | 1}, Strip::Type::RAILROAD));
+		add(diff, strip(2, 4, {1 << 8}));
+		add(diff, strip(1, 4, {2 << 8}));
+
+		SplineNetwork network;
+		network.applyDiff(std::move(diff));
+		return network;
+	}
+
+	/// The anchors a path passes through, starting with `from`
+	std::vector<uint32_t> anchorsAlong(const NetworkGraph::Path &path, uint32_t from) {
+		std::vector<uint32_t> anchors{from};
+		for (const auto &step : path.steps)
+			anchors.push_back(step.to);
+		return anchors;
+	}
+
+	void shortestPath() {
+		const NetworkGraph graph(network());
+		check(graph.nodeCount() == 4, "only hub anchors are nodes");
+		check(graph.edgeCount() == 3, "every strip is an edge");
+
+		const auto path = graph.shortestPath(1, 4);
+		check(path && anchorsAlong(*path, 1) == std::vector<uint32_t>{1, 2, 4},
+		      "the shorter path over more strips is found");
+		check(path && path->length == 20, "the path length is the length of its routes");
+		check(path && path->steps.size() == 2 && path->steps[0].type == Strip::Type::RAILROAD &&
+		          path->steps[1].type == Strip::Type::DIRT_ROAD,
+		      "every step has the type of its strip");
+
+		const auto back = graph.shortestPath(4, 1);
+		check(back && anchorsAlong(*back, 4) == std::vector<uint32_t>{4, 2, 1}, "strips are used in both directions");
+
+		const auto nowhere = graph.shortestPath(1, 1);
+		check(nowhere && nowhere->steps.empty() && nowhere->length == 0, "the path to the start is empty");
+	}
+
+	void typeFilter() {
+		const std::array roads{Strip::Type::DIRT_ROAD};
+		const NetworkGraph graph(network(), roads);
+		check(graph.edgeCount() == 2, "strips of other types are left out");
+
+		const auto path = graph.shortestPath(1, 4);
+		check(path && anchorsAlong(*path, 1) == std::vector<uint32_t>{1, 4},
+		      "the path avoids strips of other types");
+		check(path && std::abs(path->length - 2 * std::hypot(10.f, 10.f)) < 1e-3f,
+		      "the winding route is measured through its sub-anchor");
+	}
+
+	void unreachable() {
+		const NetworkGraph graph(network());
+		check(!graph.shortestPath(1, 5), "there is no path to an unconnected anchor");
+		check(!graph.shortestPath(1, 3), "there is no path to a missing anchor");
+		check(!graph.shortestPath(1, 1 | subAnchorBit), "there is no path to a sub-anchor");
+
+		const auto components = graph.components();
+		check(components == std::vector<std::vector<uint32_t>>{{1, 2, 4}, {5}},
+		      "the connected components are found, largest first");
+	}
+} // namespace
+
+int main() {
+	shortestPath();
+	typeFilter();
+	unreachable();
+	return failures ? 1 : 0;
+}
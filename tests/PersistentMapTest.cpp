@@ -0,0 +1,139 @@
+// Changes persistent maps with tiny chunks alongside a std::map, checking they always agree, that chunks are split
+// and joined within their bounds, and that copies share every chunk a change doesn't touch
+// Usage: PersistentMapTest
+
+#include "TestNetworks.hpp"
+
+#include <map>
+#include <random>
+
+#include "SplineNetwork/PersistentMap.hpp"
+
+using namespace test;
+
+namespace {
+	constexpr size_t chunkSize = 4;
+	using SmallMap = PersistentMap<int, int, chunkSize>;
+
+	bool sameItem(const std::pair<int, int> &item, const std::pair<const int, int> &modelItem) {
+		return item.first == modelItem.first && item.second == modelItem.second;
+	}
+	/// Whether `map` holds exactly what `model` does, read forwards, backwards, and by key
+	bool matches(const SmallMap &map, const std::map<int, int> &model) {
+		if (map.size() != model.size() || !std::equal(map.begin(), map.end(), model.begin(), model.end(), sameItem))
+			return false;
+		if (!std::equal(std::make_reverse_iterator(map.end()), std::make_reverse_iterator(map.begin()),
+		                model.rbegin(), model.rend(), sameItem))
+			return false;
+		return std::ranges::all_of(model, [&](const auto &item) {
+			return map.contains(item.first) && map.at(item.first) == item.second;
+		});
+	}
+	/// Every chunk holds chunkSize / 2 to 2 * chunkSize - 1 items, unless there is only one
+	bool balanced(const SmallMap &map) {
+		const auto chunks = map.chunkCount();
+		if (chunks <= 1)
+			return chunks == (map.empty() ? 0 : 1);
+		return chunks * (chunkSize / 2) <= map.size() && map.size() <= chunks * (2 * chunkSize - 1);
+	}
+
+	void randomChanges() {
+		std::mt19937 random(35);
+		std::uniform_int_distribution<int> keys(0, 200);
+		std::uniform_int_distribution<int> operations(0, 9);
+
+		SmallMap map;
+		std::map<int, int> model;
+		// Kept as it was at some point, to check later changes never reach it
+		SmallMap snapshot;
+		std::map<int, int> snapshotModel;
+		for (int step = 0; step < 20'000; ++step) {
+			const auto key = keys(random);
+			// Grows the map for the first half, and mostly shrinks it in the second, so chunks both split and join
+			const auto operation = operations(random) + (step < 10'000 ? 0 : 4);
+			if (operation < 3) {
+				check(map.emplace(key, step) == model.emplace(key, step).second, "emplace reports what it did");
+			} else if (operation < 6) {
+				map.insert_or_assign(key, step);
+				model.insert_or_assign(key, step);
+			} else if (operation < 9 || model.empty()) {
+				check(map.erase(key) == model.erase(key), "erase by key reports what it did");
+			} else {
+				// Erase by position, from the middle of the map
+				const auto position = std::next(model.begin(), static_cast<std::ptrdiff_t>(model.size() / 2));
+				map.erase(map.find(position->first));
+				model.erase(position);
+			}
+
+			if (step % 1'000 == 0) {
+				snapshot = map;
+				snapshotModel = model;
+			}
+			if (!matches(map, model) || !balanced(map)) {
+				check(false, fmt::format("the map matches the model and stays balanced after step {}", step));
+				return;
+			}
+		}
+		check(matches(snapshot, snapshotModel), "a copy is unaffected by changes to the original");
+	}
+
+	void boundaries() {
+		SmallMap map;
+		for (int key = 0; key < 2 * static_cast<int>(chunkSize); ++key)
+			map.emplace(key, key);
+		check(map.chunkCount() == 2, "a full chunk is split in two");
+
+		// Emptying the first chunk joins what is left into the second
+		for (int key = 0; key < static_cast<int>(chunkSize); ++key)
+			map.erase(key);
+		check(map.chunkCount() == 1 && map.size() == chunkSize, "an undersized chunk is joined with its neighbour");
+		check(map.begin()->first == static_cast<int>(chunkSize), "joining keeps the items in order");
+
+		// Keys before everything go in the first chunk, keys after everything in the last
+		map.emplace(-1, -1);
+		map.emplace(1'000, 1'000);
+		check(map.begin()->first == -1 && std::prev(map.end())->first == 1'000, "keys at both ends are in order");
+	}
+
+	void sharing() {
+		PersistentMap<int, int> map;
+		for (int key = 0; key < 10'000; ++key)
+			map.emplace(key, key);
+
+		auto changed = map;
+		check(changed.sharedChunks(map) == map.chunkCount(), "a copy shares every chunk");
+		changed.insert_or_assign(5'000, -1);
+		check(changed.sharedChunks(map) == map.chunkCount() - 1, "changing one item only copies its chunk");
+		check(map.at(5'000) == 5'000, "the original keeps the old value");
+		changed.erase(7'000);
+		check(changed.sharedChunks(map) == map.chunkCount() - 2, "erasing one item only copies its chunk");
+	}
+
+	void networkSharing() {
+		Diff build;
+		for (uint32_t id = 1; id <= 5'000; ++id)
+			add(build, anchor(id, static_cast<float>(id), 0));
+		SplineNetwork network;
+		network.applyDiff(std::move(build));
+
+		auto edited = network;
+		Diff move;
+		move.anchorChanges.edits.emplace(2'500, std::pair(anchor(2'500, 2'500, 0), anchor(2'500, 2'500, 10)));
+		edited.applyDiff(std::move(move));
+		check(edited.anchors().sharedChunks(network.anchors()) == network.anchors().chunkCount() - 1,
+		      "a network copy with one anchor moved shares every other chunk");
+
+		const auto diff = network.calculateDiff(edited);
+		check(diff.anchorChanges.edits.size() == 1 && diff.anchorChanges.additions.empty() &&
+		          diff.anchorChanges.deletions.empty(),
+		      "the diff between the versions only holds the moved anchor");
+	}
+} // namespace
+
+int main() {
+	randomChanges();
+	boundaries();
+	sharing();
+	networkSharing();
+	return failures ? 1 : 0;
+}
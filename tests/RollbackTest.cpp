@@ -0,0 +1,55 @@
+// Applies diffs that fail partway through and checks the network is left exactly as it was
+// Usage: RollbackTest
+
+#include "TestNetworks.hpp"
+
+using namespace test;
+
+namespace {
+	SplineNetwork baseNetwork() {
+		Diff diff;
+		add(diff, anchor(1, 0, 0));
+		add(diff, anchor(2, 10, 0));
+		add(diff, anchor(3, 20, 0));
+		add(diff, anchor(1 | subAnchorBit, 5, 1));
+		add(diff, route(1 << 8, {1, 1 | subAnchorBit, 2}));
+		add(diff, strip(1, 2, {1 << 8}));
+
+		SplineNetwork network;
+		network.applyDiff(std::move(diff));
+		return network;
+	}
+
+	/// Changes anchors and routes, which are applied before and after strips, and adds a strip the network already has
+	/// Strip keys are hub ids that never get remapped, so nothing resolves the collision before applying
+	Diff collidingDiff() {
+		Diff diff;
+		diff.anchorChanges.edits.emplace(2, std::pair(anchor(2, 10, 0), anchor(2, 12, 0)));
+		diff.anchorChanges.deletions.emplace(3, anchor(3, 20, 0));
+		add(diff, anchor(4, 30, 0));
+		add(diff, anchor(2 | subAnchorBit, 6, 2));
+		diff.routeChanges.edits.emplace(1 << 8, std::pair(route(1 << 8, {1, 1 | subAnchorBit, 2}),
+		                                                  route(1 << 8, {1, 2 | subAnchorBit, 2})));
+		add(diff, strip(1, 2, {1 << 8}));
+		return diff;
+	}
+} // namespace
+
+int main() {
+	auto network = baseNetwork();
+	const auto original = network;
+	checkThrows([&] { network.applyDiff(collidingDiff()); }, "adding a strip the network already has is refused");
+	check(sameNetwork(network, original), "a failed applyDiff leaves the network unchanged");
+
+	checkThrows([&] { network.applyDiffs({collidingDiff(), Diff()}); },
+	            "applying diffs that add a strip the network already has is refused");
+	check(sameNetwork(network, original), "failed applyDiffs leaves the network unchanged");
+
+	// The rollback mustn't get in the way of a diff that does apply
+	auto edited = collidingDiff();
+	edited.stripChanges.additions.clear();
+	network.applyDiff(std::move(edited));
+	check(!sameNetwork(network, original), "the same changes without the colliding strip are applied");
+
+	return failures ? 1 : 0;
+}
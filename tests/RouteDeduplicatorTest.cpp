@@ -0,0 +1,43 @@
+// Deduplicates a small network and checks only the duplicate route goes, with every strip kept and pointed at the
+// surviving route
+// Usage: RouteDeduplicatorTest
+
+#include "TestNetworks.hpp"
+
+#include "SplineNetwork/RouteDeduplicator.hpp"
+
+using namespace test;
+
+int main() {
+	constexpr uint32_t route = 1 << 8;
+	constexpr uint32_t duplicate = 2 << 8;
+	constexpr uint32_t subAnchor = 1 | subAnchorBit;
+	constexpr uint32_t duplicateSubAnchor = 2 | subAnchorBit;
+
+	Diff build;
+	add(build, anchor(1, 0, 0));
+	add(build, anchor(2, 10, 0));
+	add(build, anchor(subAnchor, 5, 1));
+	// The same position under another id, which is how merged networks end up with duplicate routes
+	add(build, anchor(duplicateSubAnchor, 5, 1));
+	add(build, test::route(route, {1, subAnchor, 2}));
+	add(build, test::route(duplicate, {1, duplicateSubAnchor, 2}));
+	add(build, strip(1, 2, {route}));
+	// Runs the other way over the same route, which is a different strip and has to stay
+	add(build, strip(2, 1, {route}));
+	add(build, strip(1, 2, {duplicate}, Strip::Type::RAILROAD));
+
+	SplineNetwork network;
+	network.applyDiff(std::move(build));
+	const auto original = network;
+	network.applyDiff(RouteDeduplicator::deduplicate(network));
+
+	check(network.routes().contains(route) && !network.routes().contains(duplicate), "the duplicate route is removed");
+	check(network.anchors().contains(subAnchor) && !network.anchors().contains(duplicateSubAnchor),
+	      "the sub-anchor only the duplicate used is removed");
+	check(network.strips().size() == original.strips().size(), "every strip is kept, including the reversed one");
+	for (const auto &strip : network.strips() | std::views::values)
+		check(strip.routeIDs() == std::vector<uint64_t>{route}, fmt::format("{} uses the surviving route", strip));
+
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,101 @@
+// Simplifies the example networks and checks every removed sub-anchor is within the tolerance of the simplified route
+// Usage: RouteSimplifierTest <directory with .splnet files>
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <iostream>
+#include <ranges>
+
+#include <fmt/ostream.h>
+
+#include "SplineNetwork/RouteSimplifier.hpp"
+#include "SplineNetwork/SplineNetwork.hpp"
+
+namespace fs = std::filesystem;
+
+namespace {
+	constexpr float tolerance = 0.5f;
+	// Room for the rounding of float positions
+	constexpr float epsilon = 1e-3f;
+
+	float distanceToSegment(const Anchor &point, const Anchor &start, const Anchor &end) {
+		const auto dx = end.posX() - start.posX();
+		const auto dy = end.posY() - start.posY();
+		const auto px = point.posX() - start.posX();
+		const auto py = point.posY() - start.posY();
+		const auto lengthSquared = dx * dx + dy * dy;
+		const auto t = lengthSquared > 0 ? std::clamp((px * dx + py * dy) / lengthSquared, 0.0f, 1.0f) : 0.0f;
+		return std::hypot(px - t * dx, py - t * dy);
+	}
+
+	/// The number of anchors removed, or -1 if any is too far from the simplified route
+	long checkNetwork(const fs::path &path) {
+		const SplineNetwork network(path);
+		const auto diff = RouteSimplifier(network, tolerance).simplify(2);
+
+		long removed = 0;
+		bool failed = false;
+		for (const auto &[oldRoute, newRoute] : diff.routeChanges.edits | std::views::values) {
+			const auto &oldAnchors = oldRoute.anchors();
+			const auto &newAnchors = newRoute.anchors();
+
+			// The kept anchors are in the same order, every removed one lies between two of them
+			size_t next = 0;
+			for (size_t i = 0; i < oldAnchors.size(); ++i) {
+				if (next < newAnchors.size() && oldAnchors[i] == newAnchors[next]) {
+					++next;
+					continue;
+				}
+				if (next == 0 || next == newAnchors.size()) {
+					fmt::print(std::cerr, "{}: {} removed the end of the route.\n", path.string(), oldRoute);
+					failed = true;
+					continue;
+				}
+
+				removed++;
+				const auto &anchor = network.anchors().at(oldAnchors[i]);
+				const auto distance = distanceToSegment(anchor, network.anchors().at(newAnchors[next - 1]),
+				                                        network.anchors().at(newAnchors[next]));
+				if (distance > tolerance + epsilon) {
+					fmt::print(std::cerr, "{}: {} removed from {} is {:.3f} px from the simplified route.\n",
+					           path.string(), anchor, oldRoute, distance);
+					failed = true;
+				}
+			}
+			if (next != newAnchors.size()) {
+				fmt::print(std::cerr, "{}: {} gained or reordered anchors.\n", path.string(), oldRoute);
+				failed = true;
+			}
+		}
+		return failed ? -1 : removed;
+	}
+} // namespace
+
+int main(int argc, char *argv[]) {
+	if (argc != 2) {
+		fmt::print(std::cerr, "Usage: {} <directory with .splnet files>\n", argv[0]);
+		return 2;
+	}
+
+	bool failed = false;
+	long totalRemoved = 0;
+	for (const auto &entry : fs::directory_iterator(argv[1])) {
+		if (entry.path().extension() != ".splnet")
+			continue;
+		const auto removed = checkNetwork(entry.path());
+		fmt::print("{}: {}\n", entry.path().filename().string(),
+		           removed < 0 ? "FAILED" : fmt::format("{} removed", removed));
+		if (removed < 0)
+			failed = true;
+		else
+			totalRemoved += removed;
+	}
+
+	// A simplifier that removes nothing would pass everything above
+	if (totalRemoved == 0) {
+		fmt::print(std::cerr, "No anchors were removed from any network.\n");
+		failed = true;
+	}
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,115 @@
+// Indexes the example networks and checks every record can be looked up and decoded on its own
+// Usage: SplnetIndexTest <directory with .splnet files>
+
+#include <filesystem>
+#include <iterator>
+
+#include "TestNetworks.hpp"
+
+#include "SplineNetwork/FileHandler/MappedFile.hpp"
+#include "SplineNetwork/FileHandler/SplnetIndex.hpp"
+
+namespace fs = std::filesystem;
+using namespace test;
+
+namespace {
+	template <typename T> T decode(const MappedFile &file, const SplnetIndex::Record &record) {
+		SplnetFileReader fileReader(file.data(), record.offset);
+		return T(fileReader, record.isFinal);
+	}
+
+	/// Every item in the network is found by the index and decodes to the same item
+	void checkLookups(const fs::path &path) {
+		SplnetIndex index;
+		const SplineNetwork network(path, &index);
+		const MappedFile file(path);
+		const auto name = path.filename().string();
+
+		bool anchorsFound = true;
+		for (const auto &[id, anchor] : network.anchors()) {
+			const auto record = index.findAnchor(id);
+			anchorsFound &= record && decode<Anchor>(file, *record) == anchor;
+		}
+		check(anchorsFound, fmt::format("{}: every anchor is found", name));
+
+		bool routesFound = true;
+		for (const auto &[id, route] : network.routes()) {
+			const auto record = index.findRoute(id);
+			routesFound &= record && decode<Route>(file, *record) == route;
+		}
+		check(routesFound, fmt::format("{}: every route is found", name));
+
+		bool stripsFound = true;
+		for (const auto &strip : network.strips() | std::views::values) {
+			bool found = false;
+			for (const auto &record : index.findStrips(strip.sourceID(), strip.destinationID()))
+				found |= decode<Strip>(file, record) == strip;
+			stripsFound &= found;
+		}
+		check(stripsFound, fmt::format("{}: every strip is found", name));
+
+		if (!network.anchors().empty()) {
+			const auto missing = std::prev(network.anchors().end())->first + 1;
+			check(!index.findAnchor(missing), fmt::format("{}: a missing anchor is not found", name));
+			check(index.findStrips(missing, missing).empty(), fmt::format("{}: missing strips are not found", name));
+
+			const auto record = index.findAnchor(network.anchors().begin()->first);
+			const auto location = index.locate(record->offset + 1);
+			check(location && location->type == SplnetIndex::RecordType::Anchor &&
+			          location->record.offset == record->offset,
+			      fmt::format("{}: an offset inside a record is located at its start", name));
+		}
+		check(!index.isStale(path), fmt::format("{}: a fresh index is not stale", name));
+	}
+
+	/// Strips of every type between the same anchors, and the index written next to the network
+	void stripTypesAndSidecar(const fs::path &directory) {
+		Diff diff;
+		add(diff, anchor(1, 0, 0));
+		add(diff, anchor(2, 10, 0));
+		add(diff, route(1 << 8, {1, 2}));
+		add(diff, strip(1, 2, {1 << 8}));
+		add(diff, strip(1, 2, {1 << 8}, Strip::Type::RAILROAD));
+		add(diff, strip(2, 1, {1 << 8}));
+		SplineNetwork network;
+		network.applyDiff(std::move(diff));
+
+		const auto path = directory / "strips.splnet";
+		network.writeToFile(path, true);
+		const auto indexPath = SplnetIndex::sidecarPath(path);
+		check(fs::exists(indexPath), "the index is written next to the network");
+
+		const SplnetIndex index(indexPath);
+		check(!index.isStale(path), "the index read back is not stale");
+		check(index.findStrips(1, 2).size() == 2, "strips of every type between two anchors are found");
+		check(index.findStrips(2, 1).size() == 1, "strips in the other direction are found separately");
+
+		// Writing without asking for an index still keeps the existing one up to date
+		network.applyDiff([] {
+			Diff diff;
+			add(diff, anchor(3, 20, 0));
+			return diff;
+		}());
+		network.writeToFile(path);
+		check(index.isStale(path), "the index of a network since changed is stale");
+		check(SplnetIndex(indexPath).findAnchor(3).has_value(), "an existing index is rewritten with the network");
+	}
+} // namespace
+
+int main(int argc, char *argv[]) {
+	if (argc != 2) {
+		fmt::print(std::cerr, "Usage: {} <directory with .splnet files>\n", argv[0]);
+		return 2;
+	}
+
+	for (const auto &entry : fs::directory_iterator(argv[1])) {
+		if (entry.path().extension() == ".splnet")
+			checkLookups(entry.path());
+	}
+
+	const auto directory = fs::temp_directory_path() / "SplnetIndexTest";
+	fs::create_directories(directory);
+	stripTypesAndSidecar(directory);
+	fs::remove_all(directory);
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,67 @@
+// Shared by the tests, building small networks and diffs by hand and reporting failed checks
+#pragma once
+
+#include <iostream>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <fmt/ostream.h>
+
+#include "SplineNetwork/SplineNetwork.hpp"
+
+namespace test {
+	inline int failures = 0;
+
+	/// Print `what` if `condition` doesn't hold, the test fails at the end if anything did
+	inline void check(bool condition, std::string_view what) {
+		if (!condition) {
+			fmt::print(std::cerr, "Failed: {}\n", what);
+			failures++;
+		}
+	}
+	/// Check that `function` throws, for inputs that have to be refused
+	template <typename F> void checkThrows(F function, std::string_view what) {
+		try {
+			function();
+		} catch (const std::exception &) {
+			return;
+		}
+		check(false, what);
+	}
+
+	constexpr uint32_t subAnchorBit = 1 << 28;
+	constexpr uint32_t waterBit = 1 << 23;
+
+	inline Anchor anchor(uint32_t id, float x, float y) {
+		Anchor anchor;
+		anchor.id(id);
+		anchor.posX(x);
+		anchor.posY(y);
+		return anchor;
+	}
+	inline Route route(uint32_t id, std::vector<uint32_t> anchors) {
+		Route route;
+		route.id(id);
+		route.anchors(std::move(anchors));
+		return route;
+	}
+	/// A strip between two hub anchors, which can't be given a type any other way
+	inline Strip strip(uint32_t source, uint32_t destination, std::vector<uint64_t> routes,
+	                   Strip::Type type = Strip::Type::DIRT_ROAD) {
+		return nlohmann::json{{"_sourceID", source << 6 | static_cast<uint32_t>(type)},
+		                      {"_destinationID", destination << 3},
+		                      {"_routeIDs", std::move(routes)}}
+		    .get<Strip>();
+	}
+
+	inline void add(Diff &diff, Anchor anchor) { diff.anchorChanges.additions.emplace(anchor.id(), std::move(anchor)); }
+	inline void add(Diff &diff, Route route) { diff.routeChanges.additions.emplace(route.id(), std::move(route)); }
+	inline void add(Diff &diff, Strip strip) { diff.stripChanges.additions.emplace(strip.idPair(), std::move(strip)); }
+
+	/// Whether both networks contain exactly the same items
+	inline bool sameNetwork(const SplineNetwork &first, const SplineNetwork &second) {
+		return first.anchors() == second.anchors() && first.routes() == second.routes() &&
+		       first.strips() == second.strips();
+	}
+} // namespace test